@@ -26,6 +26,11 @@ declare length=256
 
 declare N=10
 
+# Threads per process and binding used for NUMA-aware first touch.
+export OMP_NUM_THREADS=$SLURM_CPUS_PER_TASK
+export OMP_PLACES=cores
+export OMP_PROC_BIND=close
+
 for ((i=0;i<N;i++))
 do
         mpirun -n $ntasks ./automaton -l $length -e 0 -w 0 1
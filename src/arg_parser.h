@@ -7,6 +7,8 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "rules.h"
+
 
 #define DEFAULT_PROB 0.49
 #define DEFAULT_LENGTH 768
@@ -14,6 +16,44 @@
 #define DEFAULT_PRINT_INTERVAL 100
 #define DEFAULT_WRITE_TO_FILE 1
 #define DEFAULT_EARLY_STOPPING 1
+#define DEFAULT_PACKED 0
+#define DEFAULT_RULE MPP_RULE
+#define DEFAULT_HALO_DEPTH 1
+#define DEFAULT_OVERLAP 0
+#define DEFAULT_STATS_INTERVAL 1
+#define DEFAULT_WIDTH 0
+#define DEFAULT_HEIGHT 0
+#define DEFAULT_TILE_SIZE 0
+#define DEFAULT_ACTIVITY 0
+#define DEFAULT_REBALANCE_INTERVAL 0
+#define DEFAULT_CYCLE_WINDOW 0
+#define DEFAULT_CHECKSUM_INTERVAL 0
+#define DEFAULT_CHECKPOINT_INTERVAL 0
+#define DEFAULT_CHECKPOINT_FILE "checkpoint.pbm"
+#define DEFAULT_RESTART NULL
+#define DEFAULT_FRAME_INTERVAL 0
+#define DEFAULT_INPUT NULL
+
+#define EXCHANGE_P2P 0
+#define EXCHANGE_DATATYPE 1
+#define EXCHANGE_NEIGHBOUR 2
+#define EXCHANGE_SHARED 3
+#define EXCHANGE_RMA 4
+#define EXCHANGE_COUNT 5
+#define DEFAULT_EXCHANGE EXCHANGE_P2P
+
+#define OUTPUT_GLOBAL 0
+#define OUTPUT_TILES 1
+#define OUTPUT_BINARY_TILES 2
+#define OUTPUT_COUNT 3
+#define DEFAULT_OUTPUT OUTPUT_GLOBAL
+
+#define PERIODIC_NONE 0
+#define PERIODIC_VERTICAL 1
+#define PERIODIC_HORIZONTAL 2
+#define PERIODIC_BOTH 3
+#define PERIODIC_COUNT 4
+#define DEFAULT_PERIODIC PERIODIC_VERTICAL
 
 
 const char *argp_program_version = "automaton 0.0.1";
@@ -21,13 +61,38 @@ const char *argp_program_bug_address = "SECRET@sms.ed.ac.uk";
 static char doc[] = "MPI-based distributed 2D cellular automaton.";
 static char args_doc[] = "[SEED]...";
 
+static const char *exchange_names[EXCHANGE_COUNT] = {"p2p", "datatype", "neighbour", "shared", "rma"};
+static const char *periodic_names[PERIODIC_COUNT] = {"none", "vertical", "horizontal", "both"};
+static const char *output_names[OUTPUT_COUNT] = {"global", "tiles", "binary_tiles"};
+
 static struct argp_option options[] = {
         {"prob",           'p', "NUM", 0, "Probability of a cell being alive."},
         {"length",         'l', "NUM", 0, "Side length."},
+        {"width",          'W', "NUM", 0, "Width of the population, overrides side length."},
+        {"height",         'H', "NUM", 0, "Height of the population, overrides side length."},
         {"max_steps",      'm', "NUM", 0, "Maximum number of steps."},
         {"print_interval", 'i', "NUM", 0, "Number of steps between printing stats."},
         {"write_to_file",  'w', "NUM", 0, "If 0, final IO is suppressed."},
+        {"output",         'O', "NAME", 0, "Final output: global (default) binary PBM written collectively, or ASCII tiles or binary_tiles of every process."},
         {"early_stopping", 'e', "NUM", 0, "If 0, early stopping is suppressed."},
+        {"packed",         'b', "NUM", 0, "If 1, cells are bit-packed 64 per word."},
+        {"rule",           'r', "SUMS", 0, "Comma-separated state sums that give a live cell (default 2,4,5)."},
+        {"halo_depth",     'k', "NUM", 0, "Halo depth. Halos are swapped once every NUM steps."},
+        {"overlap",        'o', "NUM", 0, "If 1, halo swaps overlap with computation of interior cells."},
+        {"stats_interval", 's', "NUM", 0, "Number of steps between computing stats and checking early stopping."},
+        {"exchange",       'x', "NAME", 0, "Halo exchange backend: p2p (default), datatype, neighbour, shared or rma."},
+        {"periodic",       'P', "DIMS", 0, "Dimensions that wrap around: none, vertical (default), horizontal or both."},
+        {"tile_size",      't', "NUM", 0, "Side length of tiles computed as tasks. If 0, rows are split across threads."},
+        {"activity",       'a', "NUM", 0, "If 1, only tiles next to cells that changed at the previous step are computed."},
+        {"rebalance_interval", 'R', "NUM", 0, "Number of steps between rebalancing partitions. If 0, partitions are fixed."},
+        {"cycle_window",   'c', "NUM", 0, "Number of past stats steps searched for a repeated population. If 0, cycles are not detected."},
+        {"checksum_interval", 'C', "NUM", 0, "Number of steps between printing global population checksums. If 0, checksums are not computed."},
+        {"checkpoint_interval", 'K', "NUM", 0, "Number of steps between saving checkpoints. If 0, checkpoints are not saved."},
+        {"checkpoint_file", 'Y', "FILE", 0, "Checkpoint to save (default checkpoint.pbm). Concurrent runs in one directory need distinct files."},
+        {"restart",        'S', "FILE", 0, "Checkpoint to restart from instead of a random population."},
+        {"frame_interval", 'F', "NUM", 0, "Number of steps between writing frames in the background. If 0, frames are not written."},
+        {"input",          'I', "FILE", 0, "ASCII or binary PBM, or RLE pattern to start from instead of a random population."},
+        {"input_offset",   'L', "ROW,COL", 0, "Position of the upper left corner of the input pattern (default 0,0)."},
         {0}
 };
 
@@ -38,14 +103,108 @@ static struct argp_option options[] = {
 typedef struct {
     double prob;
     int length;
+    int width;
+    int height;
     int max_steps;
     int print_interval;
     int seed;
     int write_to_file;
+    int output;
     int early_stopping;
+    int packed;
+    unsigned int rule;
+    int halo_depth;
+    int overlap;
+    int exchange;
+    int stats_interval;
+    int periods[2];
+    int tile_size;
+    int activity;
+    int rebalance_interval;
+    int cycle_window;
+    int checksum_interval;
+    int checkpoint_interval;
+    char *checkpoint_file;
+    char *restart;
+    int frame_interval;
+    char *input;
+    int input_offset[2];
 } Arguments;
 
 
+/**
+ * Parses name of a halo exchange backend.
+ *
+ * @param str       Backend name.
+ * @param exchange  Parsed backend.
+ * @return          True if name is valid, otherwise false.
+ */
+bool parse_exchange(const char *str, int *exchange) {
+    for (int i = 0; i < EXCHANGE_COUNT; i++) {
+        if (strcmp(str, exchange_names[i]) == 0) {
+            *exchange = i;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+/**
+ * Parses name of a final output mode.
+ *
+ * @param str       Output name.
+ * @param output    Parsed output mode.
+ * @return          True if name is valid, otherwise false.
+ */
+bool parse_output(const char *str, int *output) {
+    for (int i = 0; i < OUTPUT_COUNT; i++) {
+        if (strcmp(str, output_names[i]) == 0) {
+            *output = i;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+/**
+ * Parses periodic dimensions of the population. Vertical periodicity wraps the upper edge around to the lower edge,
+ * horizontal periodicity wraps the left edge around to the right edge.
+ *
+ * @param str       Name of periodic dimensions.
+ * @param periods   Parsed periodicity of rows and columns of the process grid.
+ * @return          True if name is valid, otherwise false.
+ */
+bool parse_periodic(const char *str, int *periods) {
+    for (int i = 0; i < PERIODIC_COUNT; i++) {
+        if (strcmp(str, periodic_names[i]) == 0) {
+            periods[0] = (i & PERIODIC_VERTICAL) != 0;
+            periods[1] = (i & PERIODIC_HORIZONTAL) != 0;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+/**
+ * Parses position of the input pattern within the population.
+ *
+ * @param str       Comma-separated row and column.
+ * @param offset    Parsed row and column.
+ * @return          True if position is valid, otherwise false.
+ */
+bool parse_input_offset(const char *str, int *offset) {
+    int len = 0;
+
+    return sscanf(str, "%d,%d%n", &offset[0], &offset[1], &len) == 2 && str[len] == '\0';
+}
+
+
 /**
  * Main parsing routine.
  *
@@ -73,6 +232,22 @@ static error_t parse_opt(int key, char *arg, struct argp_state *state) {
             break;
         case 'l':
             arguments->length = atoi(arg);
+            break;
+        case 'W':
+            arguments->width = atoi(arg);
+
+            if (arguments->width < 1) {
+                argp_usage(state);
+            }
+
+            break;
+        case 'H':
+            arguments->height = atoi(arg);
+
+            if (arguments->height < 1) {
+                argp_usage(state);
+            }
+
             break;
         case 'm':
             arguments->max_steps = atoi(arg);
@@ -85,6 +260,113 @@ static error_t parse_opt(int key, char *arg, struct argp_state *state) {
             break;
         case 'e':
             arguments->early_stopping = atoi(arg);
+            break;
+        case 'b':
+            arguments->packed = atoi(arg);
+            break;
+        case 'r':
+            if (!parse_rule(arg, &arguments->rule)) {
+                argp_usage(state);
+            }
+            break;
+        case 'o':
+            arguments->overlap = atoi(arg);
+            break;
+        case 's':
+            arguments->stats_interval = atoi(arg);
+
+            if (arguments->stats_interval < 1) {
+                argp_usage(state);
+            }
+
+            break;
+        case 'x':
+            if (!parse_exchange(arg, &arguments->exchange)) {
+                argp_usage(state);
+            }
+            break;
+        case 'O':
+            if (!parse_output(arg, &arguments->output)) {
+                argp_usage(state);
+            }
+            break;
+        case 'P':
+            if (!parse_periodic(arg, arguments->periods)) {
+                argp_usage(state);
+            }
+            break;
+        case 't':
+            arguments->tile_size = atoi(arg);
+
+            if (arguments->tile_size < 0) {
+                argp_usage(state);
+            }
+
+            break;
+        case 'a':
+            arguments->activity = atoi(arg);
+            break;
+        case 'R':
+            arguments->rebalance_interval = atoi(arg);
+
+            if (arguments->rebalance_interval < 0) {
+                argp_usage(state);
+            }
+
+            break;
+        case 'c':
+            arguments->cycle_window = atoi(arg);
+
+            if (arguments->cycle_window < 0) {
+                argp_usage(state);
+            }
+
+            break;
+        case 'C':
+            arguments->checksum_interval = atoi(arg);
+
+            if (arguments->checksum_interval < 0) {
+                argp_usage(state);
+            }
+
+            break;
+        case 'K':
+            arguments->checkpoint_interval = atoi(arg);
+
+            if (arguments->checkpoint_interval < 0) {
+                argp_usage(state);
+            }
+
+            break;
+        case 'Y':
+            arguments->checkpoint_file = arg;
+            break;
+        case 'S':
+            arguments->restart = arg;
+            break;
+        case 'I':
+            arguments->input = arg;
+            break;
+        case 'L':
+            if (!parse_input_offset(arg, arguments->input_offset)) {
+                argp_usage(state);
+            }
+            break;
+        case 'F':
+            arguments->frame_interval = atoi(arg);
+
+            if (arguments->frame_interval < 0) {
+                argp_usage(state);
+            }
+
+            break;
+        case 'k':
+            arguments->halo_depth = atoi(arg);
+
+            if (arguments->halo_depth < 1) {
+                argp_usage(state);
+            }
+
             break;
         case ARGP_KEY_ARG:
             // Check number of args
@@ -94,9 +376,72 @@ static error_t parse_opt(int key, char *arg, struct argp_state *state) {
             arguments->seed = atoi(arg);
             break;
         case ARGP_KEY_END:
-            if (state->arg_num < 1) {
+            // Seed is only needed for a random population.
+            if (state->arg_num < 1 && !arguments->restart && !arguments->input) {
                 argp_usage(state);
             }
+
+            if (arguments->restart && arguments->input) {
+                argp_error(state, "input pattern cannot be combined with restart");
+            }
+
+            // Width and height default to side length.
+            if (arguments->width == DEFAULT_WIDTH) {
+                arguments->width = arguments->length;
+            }
+
+            if (arguments->height == DEFAULT_HEIGHT) {
+                arguments->height = arguments->length;
+            }
+
+            if (arguments->print_interval % arguments->stats_interval != 0) {
+                argp_error(state, "print interval must be a multiple of stats interval");
+            }
+
+            if (arguments->checksum_interval % arguments->stats_interval != 0) {
+                argp_error(state, "checksum interval must be a multiple of stats interval");
+            }
+
+            if (arguments->packed && arguments->halo_depth > 1) {
+                argp_error(state, "packed cells do not support deep halos");
+            }
+
+            if (arguments->overlap && (arguments->packed || arguments->halo_depth > 1)) {
+                argp_error(state, "overlap is only supported with unpacked cells and single-cell halos");
+            }
+
+            if ((arguments->exchange == EXCHANGE_SHARED || arguments->exchange == EXCHANGE_RMA) &&
+                arguments->halo_depth > 1) {
+                argp_error(state, "%s halo exchange does not support deep halos", exchange_names[arguments->exchange]);
+            }
+
+            if (arguments->tile_size > 0 && (arguments->packed || arguments->overlap)) {
+                argp_error(state, "tiles are only supported with unpacked cells without overlap");
+            }
+
+            if (arguments->activity && (arguments->tile_size == 0 || arguments->halo_depth > 1)) {
+                argp_error(state, "activity tracking requires tiles and single-cell halos");
+            }
+
+            if (arguments->rebalance_interval > 0) {
+                if (arguments->packed || arguments->exchange == EXCHANGE_SHARED ||
+                    arguments->exchange == EXCHANGE_RMA) {
+                    argp_error(state, "rebalancing is only supported with unpacked cells and p2p, datatype or "
+                                      "neighbour halo exchange");
+                }
+
+                if (arguments->rebalance_interval % arguments->halo_depth != 0) {
+                    argp_error(state, "rebalance interval must be a multiple of halo depth");
+                }
+            }
+
+            if (arguments->checkpoint_interval % arguments->halo_depth != 0) {
+                argp_error(state, "checkpoint interval must be a multiple of halo depth");
+            }
+
+            if (arguments->packed && arguments->exchange != EXCHANGE_P2P) {
+                argp_error(state, "packed cells only support p2p halo exchange");
+            }
             break;
         default:
             return ARGP_ERR_UNKNOWN;
@@ -117,10 +462,32 @@ Arguments default_args() {
     Arguments args = {
             .prob             = DEFAULT_PROB,
             .length           = DEFAULT_LENGTH,
+            .width            = DEFAULT_WIDTH,
+            .height           = DEFAULT_HEIGHT,
             .max_steps        = DEFAULT_MAX_STEPS,
             .print_interval   = DEFAULT_PRINT_INTERVAL,
             .write_to_file    = DEFAULT_WRITE_TO_FILE,
+            .output           = DEFAULT_OUTPUT,
             .early_stopping   = DEFAULT_EARLY_STOPPING,
+            .packed           = DEFAULT_PACKED,
+            .rule             = DEFAULT_RULE,
+            .halo_depth       = DEFAULT_HALO_DEPTH,
+            .overlap          = DEFAULT_OVERLAP,
+            .exchange         = DEFAULT_EXCHANGE,
+            .stats_interval   = DEFAULT_STATS_INTERVAL,
+            .periods          = {(DEFAULT_PERIODIC & PERIODIC_VERTICAL) != 0,
+                                 (DEFAULT_PERIODIC & PERIODIC_HORIZONTAL) != 0},
+            .tile_size        = DEFAULT_TILE_SIZE,
+            .activity         = DEFAULT_ACTIVITY,
+            .rebalance_interval = DEFAULT_REBALANCE_INTERVAL,
+            .cycle_window     = DEFAULT_CYCLE_WINDOW,
+            .checksum_interval = DEFAULT_CHECKSUM_INTERVAL,
+            .checkpoint_interval = DEFAULT_CHECKPOINT_INTERVAL,
+            .checkpoint_file  = DEFAULT_CHECKPOINT_FILE,
+            .restart          = DEFAULT_RESTART,
+            .frame_interval   = DEFAULT_FRAME_INTERVAL,
+            .input            = DEFAULT_INPUT,
+            .input_offset     = {0, 0},
     };
 
     return args;
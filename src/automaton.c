@@ -1,125 +1,236 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <string.h>
 #include <math.h>
 #include <mpi.h>
 
 #include "arg_parser.h"
 #include "automaton.h"
 #include "population_utils.h"
+#include "packed_population.h"
+#include "load_balancer.h"
+#include "checkpoint.h"
+#include "snapshot.h"
+#include "input.h"
 #include "io.h"
 
 
 /**
- * Runs controller process.
+ * Prints global statistics of a given step and checks early stopping criteria.
  *
- * @param sim               Simulation data.
- * @param fst_generation    Buffer containing first generation of cells.
- * @param snd_generation    Buffer containing second generation of cells.
+ * @param sim       Simulation data.
+ * @param step      Step number.
+ * @param stats     Global live cell count, delta and hash.
+ * @param verbose   If true, statistics are printed.
+ * @return          True if simulation should stop early, otherwise false.
  */
-void run_controller(SimulationData *sim, cell *fst_generation, cell *snd_generation) {
-    unsigned long long local_live_cell_count, global_live_cell_count, local_delta, global_delta;
-    cell * tmp_generation;
-
-    print_worker_data(sim);
-
-    for (unsigned int i = 0; i < sim->args->max_steps; i++) {
-        // Check if running on a single process to avoid deadlock.
-        if (sim->n_proc > 1) {
-            swap_halos(fst_generation, sim->swap_buffer, sim);
-        }
+bool check_global_stats(SimulationData *sim, unsigned int step, const unsigned long long *stats, bool verbose) {
+    if (verbose && step % sim->args->print_interval == 0) {
+        print_interval_data(step, stats[STAT_ALIVE], stats[STAT_DELTA]);
+    }
 
-        // Compute next generation.
-        update_population(
-                fst_generation,
-                snd_generation,
-                &local_live_cell_count,
-                &local_delta,
-                sim->local_augmented_height,
-                sim->local_augmented_width,
-                &mpp_update_cell,
-                &mpp_compute_state_sum
-        );
+    if (verbose && sim->args->checksum_interval > 0 && step % sim->args->checksum_interval == 0) {
+        print_checksum(step, stats[STAT_HASH]);
+    }
 
-        // Swap generations.
-        tmp_generation = fst_generation;
-        fst_generation = snd_generation;
-        snd_generation = tmp_generation;
+    if (sim->args->early_stopping) {
+        if (check_lower_threshold(stats[STAT_ALIVE], sim->lower_early_stopping_threshold)) {
+            if (verbose) {
+                print_on_lower_threshold_touch();
+            }
 
+            return true;
+        }
 
-        MPI_Allreduce(&local_live_cell_count, &global_live_cell_count, 1, MPI_UNSIGNED_LONG_LONG, MPI_SUM, sim->comm);
-        MPI_Allreduce(&local_delta, &global_delta, 1, MPI_UNSIGNED_LONG_LONG, MPI_SUM, sim->comm);
+        if (check_upper_threshold(stats[STAT_ALIVE], sim->upper_early_stopping_threshold)) {
+            if (verbose) {
+                print_on_upper_threshold_touch();
+            }
 
-        if (i % sim->args->print_interval == 0) {
-            print_interval_data(i, global_live_cell_count, global_delta);
+            return true;
         }
+    }
 
-        if (sim->args->early_stopping) {
-            if (check_lower_threshold(global_live_cell_count, sim->lower_early_stopping_threshold)) {
-                print_on_lower_threshold_touch();
-                break;
-            }
+    // Cycles are detected whenever a window is given, since a repeated population never changes again.
+    if (sim->args->cycle_window > 0) {
+        unsigned int period = find_cycle(sim, stats);
 
-            if (check_upper_threshold(global_live_cell_count, sim->upper_early_stopping_threshold)) {
-                print_on_upper_threshold_touch();
-                break;
+        if (period > 0) {
+            if (verbose) {
+                print_on_cycle(step, period);
             }
-        }
 
+            return true;
+        }
     }
+
+    return false;
 }
 
+
 /**
- *  Runs worker process.
+ * Advances population of cells until maximum number of steps is reached or early stopping criteria are met. Live cell
+ * count and delta are only computed every stats interval steps, and reduced with a single non-blocking reduction that
+ * overlaps with the next step, so early stopping is applied one step late. Partitions are rebalanced every rebalance
+ * interval steps, in which case both generations are replaced, and checkpoints are saved every checkpoint interval
+ * steps. Runs restarted from a checkpoint resume from its step. Frames are written every frame interval steps in the
+ * background, and only delay the step loop if both staging slots are still in flight.
  *
  * @param sim               Simulation data.
- * @param fst_generation    Buffer containing first generation of cells.
- * @param snd_generation    Buffer containing second generation of cells.
+ * @param fst_generation    Buffer containing first generation of cells, set to the last generation on return.
+ * @param snd_generation    Buffer containing second generation of cells, set to the other generation on return.
+ * @param step_fn_ptr       Function that advances generation of cells by a single step.
+ * @param verbose           If true, statistics are printed.
+ * @return                  Buffer containing last generation of cells.
  */
-void run_worker(SimulationData *sim, cell *fst_generation, cell *snd_generation) {
-    unsigned long long local_live_cell_count, global_live_cell_count, local_delta, global_delta;
-    cell * tmp_generation;
+void *run_simulation(
+        SimulationData *sim,
+        void **fst_generation,
+        void **snd_generation,
+        void (*step_fn_ptr)(SimulationData *, void *, void *, unsigned long long *, unsigned long long *),
+        bool verbose
+) {
+    unsigned long long local_live_cell_count, local_delta, local_stats[STAT_COUNT], global_stats[STAT_COUNT];
+    unsigned long long prev_local_hash = 0;
+    unsigned int i, stats_step = 0;
+    void *tmp_generation;
+    double start;
+
+    MPI_Request stats_req = MPI_REQUEST_NULL;
 
     print_worker_data(sim);
 
-    for (unsigned int i = 0; i < sim->args->max_steps; i++) {
-        swap_halos(fst_generation, sim->swap_buffer, sim);
+    if (sim->snapshot_queue && sim->start_step % sim->args->frame_interval == 0) {
+        write_snapshot(sim, *fst_generation, sim->start_step);
+    }
+
+    for (i = sim->start_step; i < sim->args->max_steps; i++) {
+        sim->step = i;
+        sim->count_stats = i % sim->args->stats_interval == 0;
+
+        // Cycle detection also reduces hash of the previous generation, which tells fixed points apart. It was already
+        // hashed at the previous step, unless that wasn't a stats step.
+        if (sim->count_stats && sim->args->cycle_window > 0 &&
+            (sim->args->stats_interval > 1 || i == sim->start_step)) {
+            prev_local_hash = hash_local_population(sim, *fst_generation);
+        }
 
         // Compute next generation.
-        update_population(
-                fst_generation,
-                snd_generation,
-                &local_live_cell_count,
-                &local_delta,
-                sim->local_augmented_height,
-                sim->local_augmented_width,
-                &mpp_update_cell,
-                &mpp_compute_state_sum
-        );
+        start = MPI_Wtime();
+
+        step_fn_ptr(sim, *fst_generation, *snd_generation, &local_live_cell_count, &local_delta);
+
+        sim->step_time += MPI_Wtime() - start;
 
         // Swap generations.
-        tmp_generation = fst_generation;
-        fst_generation = snd_generation;
-        snd_generation = tmp_generation;
+        tmp_generation = *fst_generation;
+        *fst_generation = *snd_generation;
+        *snd_generation = tmp_generation;
 
-        MPI_Allreduce(&local_live_cell_count, &global_live_cell_count, 1, MPI_UNSIGNED_LONG_LONG, MPI_SUM, sim->comm);
-        MPI_Allreduce(&local_delta, &global_delta, 1, MPI_UNSIGNED_LONG_LONG, MPI_SUM, sim->comm);
+        // Statistics of previous step were reduced while this step was computed.
+        if (stats_req != MPI_REQUEST_NULL) {
+            MPI_Wait(&stats_req, MPI_STATUS_IGNORE);
 
-        if (sim->args->early_stopping) {
-            if (check_lower_threshold(global_live_cell_count, sim->lower_early_stopping_threshold)) {
-                break;
+            if (check_global_stats(sim, stats_step, global_stats, verbose)) {
+                return *fst_generation;
             }
+        }
+
+        if (sim->count_stats) {
+            local_stats[STAT_ALIVE] = local_live_cell_count;
+            local_stats[STAT_DELTA] = local_delta;
+            local_stats[STAT_HASH] = is_hash_step(sim, i) ? hash_local_population(sim, *fst_generation) : 0;
+            local_stats[STAT_PREV_HASH] = prev_local_hash;
+            prev_local_hash = local_stats[STAT_HASH];
+            stats_step = i;
 
-            if (check_upper_threshold(global_live_cell_count, sim->upper_early_stopping_threshold)) {
-                break;
+            MPI_Iallreduce(local_stats, global_stats, STAT_COUNT, MPI_UNSIGNED_LONG_LONG, MPI_SUM, sim->comm, &stats_req);
+        }
+
+        if (sim->snapshot_queue) {
+            if ((i + 1) % sim->args->frame_interval == 0) {
+                write_snapshot(sim, *fst_generation, i + 1);
+            } else {
+                progress_snapshots(sim->snapshot_queue);
             }
         }
+
+        if (sim->args->checkpoint_interval > 0 && (i + 1) % sim->args->checkpoint_interval == 0 &&
+            i + 1 < sim->args->max_steps) {
+            // Statistics of this step are checked first, so that the restarted run has no pending reduction.
+            if (stats_req != MPI_REQUEST_NULL) {
+                MPI_Wait(&stats_req, MPI_STATUS_IGNORE);
+
+                if (check_global_stats(sim, stats_step, global_stats, verbose)) {
+                    return *fst_generation;
+                }
+            }
+
+            write_checkpoint(sim, *fst_generation, *snd_generation, i + 1);
+        }
+
+        if (sim->args->rebalance_interval > 0 && (i + 1) % sim->args->rebalance_interval == 0 &&
+            i + 1 < sim->args->max_steps) {
+            // Frames place pixels by partition, so their view moves along with partitions.
+            if (rebalance_population(sim, fst_generation, snd_generation, i) && sim->snapshot_queue) {
+                set_snapshot_view(sim, sim->snapshot_queue);
+            }
+        }
+    }
+
+    // Statistics of last step.
+    if (stats_req != MPI_REQUEST_NULL) {
+        MPI_Wait(&stats_req, MPI_STATUS_IGNORE);
+        check_global_stats(sim, stats_step, global_stats, verbose);
     }
+
+    return *fst_generation;
+}
+
+
+/**
+ * Runs controller process.
+ *
+ * @param sim               Simulation data.
+ * @param fst_generation    Buffer containing first generation of cells.
+ * @param snd_generation    Buffer containing second generation of cells.
+ * @param step_fn_ptr       Function that advances generation of cells by a single step.
+ * @return                  Buffer containing last generation of cells.
+ */
+void *run_controller(
+        SimulationData *sim,
+        void **fst_generation,
+        void **snd_generation,
+        void (*step_fn_ptr)(SimulationData *, void *, void *, unsigned long long *, unsigned long long *)
+) {
+    return run_simulation(sim, fst_generation, snd_generation, step_fn_ptr, true);
+}
+
+/**
+ *  Runs worker process.
+ *
+ * @param sim               Simulation data.
+ * @param fst_generation    Buffer containing first generation of cells.
+ * @param snd_generation    Buffer containing second generation of cells.
+ * @param step_fn_ptr       Function that advances generation of cells by a single step.
+ * @return                  Buffer containing last generation of cells.
+ */
+void *run_worker(
+        SimulationData *sim,
+        void **fst_generation,
+        void **snd_generation,
+        void (*step_fn_ptr)(SimulationData *, void *, void *, unsigned long long *, unsigned long long *)
+) {
+    return run_simulation(sim, fst_generation, snd_generation, step_fn_ptr, false);
 }
 
 
 int main(int argc, char *argv[]) {
-    MPI_Init(NULL, NULL);
+    int thread_support;
+
+    // Only the main thread calls MPI, outside of parallel regions.
+    MPI_Init_thread(NULL, NULL, MPI_THREAD_FUNNELED, &thread_support);
 
     unsigned long long local_live_cell_count, initial_live_cell_count;
 
@@ -128,68 +239,189 @@ int main(int argc, char *argv[]) {
 
     if (simulation.rank == CONTROLLER_RANK) {
         print_simulation_data(&simulation);
-    }
+        print_kernel_data(&simulation);
 
-    int *seeds = malloc(simulation.n_proc * sizeof(int));
+        if (thread_support < MPI_THREAD_FUNNELED && get_thread_count() > 1) {
+            printf("automaton: MPI library does not support threads, results may be incorrect\n");
+        }
+    }
 
-    // Generate seeds.
-    if (simulation.n_proc > 1) {
-        init_seeds(args.seed, simulation.n_proc, seeds);
+    // Cells are drawn from their global position, so all processes share the seed of the global population.
+    simulation.local_seed = args.seed;
+
+    unsigned int row_offset = simulation.row_cuts[simulation.x_coordinate];
+    unsigned int col_offset = simulation.col_cuts[simulation.y_coordinate];
+
+    void *fst_generation, *snd_generation;
+    void (*step_fn_ptr)(SimulationData *, void *, void *, unsigned long long *, unsigned long long *);
+
+    // Initialize local population of cells. Generations are first touched by the threads that compute them.
+    if (args.packed) {
+        unsigned int n_words = simulation.local_augmented_height * get_row_words(simulation.local_augmented_width);
+        size_t row_size = get_row_words(simulation.local_augmented_width) * sizeof(cell_word);
+
+        fst_generation = malloc(n_words * sizeof(cell_word));
+        snd_generation = malloc(n_words * sizeof(cell_word));
+
+        first_touch_population(fst_generation, simulation.local_augmented_height, row_size);
+        first_touch_population(snd_generation, simulation.local_augmented_height, row_size);
+
+        // Restarted runs read both generations from a checkpoint, and runs from a pattern read it, instead.
+        if (!args.restart && !args.input) {
+            local_live_cell_count = randomize_packed_population(
+                    fst_generation,
+                    simulation.local_augmented_height,
+                    simulation.local_augmented_width,
+                    args.prob,
+                    args.seed,
+                    row_offset,
+                    col_offset,
+                    args.width
+            );
+        }
 
-        // Initialize local random number generator.
-        simulation.local_seed = seeds[simulation.rank];
+        step_fn_ptr = &step_packed_population;
     } else {
-        simulation.local_seed = args.seed;
+        unsigned int n_cells = simulation.local_augmented_height * simulation.local_augmented_width;
+        size_t row_size = simulation.local_augmented_width * sizeof(cell);
+
+        // Generations exchanged through windows are allocated by the exchange backend.
+        if (simulation.swap_buffer->window_base) {
+            fst_generation = simulation.swap_buffer->window_base;
+            snd_generation = simulation.swap_buffer->window_base + n_cells;
+        } else {
+            fst_generation = malloc(n_cells * sizeof(cell));
+            snd_generation = malloc(n_cells * sizeof(cell));
+        }
+
+        first_touch_population(fst_generation, simulation.local_augmented_height, row_size);
+        first_touch_population(snd_generation, simulation.local_augmented_height, row_size);
+
+        // Restarted runs read both generations from a checkpoint, and runs from a pattern read it, instead.
+        if (!args.restart && !args.input) {
+            local_live_cell_count = random_augmented_population(
+                    fst_generation,
+                    simulation.local_augmented_height,
+                    simulation.local_augmented_width,
+                    simulation.halo_depth,
+                    args.prob,
+                    args.seed,
+                    row_offset,
+                    col_offset,
+                    args.width
+            );
+        }
+
+        if (simulation.tile_grid) {
+            step_fn_ptr = &step_tiled_population;
+        } else if (simulation.halo_depth > 1) {
+            step_fn_ptr = &step_deep_population;
+        } else if (args.overlap) {
+            step_fn_ptr = &step_overlapped_population;
+        } else {
+            step_fn_ptr = &step_population;
+        }
     }
 
-    srand(simulation.local_seed);
+    if (args.input) {
+        local_live_cell_count = read_input(&simulation, args.input, fst_generation);
+    }
 
-    // Initialize local population of cells.
-    cell * fst_generation = malloc(simulation.local_augmented_height * simulation.local_augmented_width * sizeof(cell));
-    cell * snd_generation = malloc(simulation.local_augmented_height * simulation.local_augmented_width * sizeof(cell));
-    local_live_cell_count = random_augmented_population(
-            fst_generation,
-            simulation.local_augmented_height,
-            simulation.local_augmented_width,
-            args.prob
-    );
+    if (args.restart) {
+        unsigned long long live_cell_count = read_checkpoint(&simulation, args.restart, fst_generation,
+                                                             snd_generation);
 
-    // Reduce local live cell counts into a global live cell count.
-    MPI_Allreduce(&local_live_cell_count, &initial_live_cell_count, 1, MPI_UNSIGNED_LONG_LONG, MPI_SUM,
-                  simulation.comm);
+        if (simulation.rank == CONTROLLER_RANK) {
+            printf("automaton: restarted from %s at step %u, live cells = %llu\n", args.restart,
+                   simulation.start_step, live_cell_count);
+        }
+    } else {
+        // Reduce local live cell counts into a global live cell count.
+        MPI_Allreduce(&local_live_cell_count, &initial_live_cell_count, 1, MPI_UNSIGNED_LONG_LONG, MPI_SUM,
+                      simulation.comm);
+
+        if (simulation.rank == CONTROLLER_RANK && args.input) {
+            printf("automaton: loaded %s, live cells = %llu, actual density = %.5f\n", args.input,
+                   initial_live_cell_count, (double) initial_live_cell_count / ((double) args.height * args.width));
+        } else if (simulation.rank == CONTROLLER_RANK) {
+            printf("automaton: rho = %.5f, live cells = %llu, actual density = %.5f\n", args.prob,
+                   initial_live_cell_count, (double) initial_live_cell_count / ((double) args.height * args.width));
+        }
 
-    if (simulation.rank == CONTROLLER_RANK) {
-        printf("automaton: rho = %.5f, live cells = %llu, actual density = %.5f\n", args.prob, initial_live_cell_count,
-               (double) initial_live_cell_count / (double) (args.length * args.length));
+        // Compute early stopping thresholds.
+        simulation.lower_early_stopping_threshold = initial_live_cell_count * LOWER_THRESHOLD_RATIO;;
+        simulation.upper_early_stopping_threshold = initial_live_cell_count * UPPER_THRESHOLD_RATIO;
     }
 
-    // Compute early stopping thresholds.
-    simulation.lower_early_stopping_threshold = initial_live_cell_count * LOWER_THRESHOLD_RATIO;;
-    simulation.upper_early_stopping_threshold = initial_live_cell_count * UPPER_THRESHOLD_RATIO;
+    if (args.frame_interval > 0) {
+        simulation.snapshot_queue = malloc(sizeof(SnapshotQueue));
+        init_snapshot_queue(&simulation, simulation.snapshot_queue);
+    }
+
+    void *last_generation;
 
     if (simulation.rank == CONTROLLER_RANK) {
-        run_controller(&simulation, fst_generation, snd_generation);
+        last_generation = run_controller(&simulation, &fst_generation, &snd_generation, step_fn_ptr);
     } else {
-        run_worker(&simulation, fst_generation, snd_generation);
+        last_generation = run_worker(&simulation, &fst_generation, &snd_generation, step_fn_ptr);
     }
 
     if (args.write_to_file) {
-        char filename[100];
+        cell *population = last_generation;
+        unsigned int halo = simulation.halo_depth;
+
+        if (args.packed) {
+            population = malloc(simulation.local_augmented_height * simulation.local_augmented_width * sizeof(cell));
+            halo = 1;
 
-        snprintf(filename, 100, "cell_%d_%d.pbm", simulation.x_coordinate, simulation.y_coordinate);
+            unpack_population(last_generation, population, simulation.local_augmented_height,
+                              simulation.local_augmented_width);
+        }
+
+        if (args.output == OUTPUT_GLOBAL) {
+            if (simulation.rank == CONTROLLER_RANK) {
+                printf("automaton: saving data to %s...\n", GLOBAL_PBM_FILENAME);
+            }
 
-        printf("automaton: rank %d is saving data to file...\n", simulation.rank);
-        to_pbm(filename, fst_generation, simulation.local_augmented_height, simulation.local_augmented_width);
+            to_global_pbm(GLOBAL_PBM_FILENAME, &simulation, population, halo);
+        } else {
+            char filename[100];
+
+            snprintf(filename, 100, "cell_%d_%d.pbm", simulation.x_coordinate, simulation.y_coordinate);
+
+            printf("automaton: rank %d is saving data to file...\n", simulation.rank);
+
+            to_pbm(filename, population, simulation.local_augmented_height, simulation.local_augmented_width, halo,
+                   args.output == OUTPUT_BINARY_TILES);
+        }
+
+        if (args.packed) {
+            free(population);
+        }
     }
 
     // Free resources.
-    free(seeds);
-    free(fst_generation);
-    free(snd_generation);
+    if (!simulation.swap_buffer->window_base) {
+        free(fst_generation);
+        free(snd_generation);
+    }
 
     free_swap_buffer(simulation.swap_buffer);
     free(simulation.swap_buffer);
 
+    free(simulation.row_cuts);
+    free(simulation.col_cuts);
+    free(simulation.cycle_history);
+
+    if (simulation.tile_grid) {
+        free_tile_grid(simulation.tile_grid);
+    }
+
+    if (simulation.snapshot_queue) {
+        free_snapshot_queue(simulation.snapshot_queue);
+        free(simulation.snapshot_queue);
+    }
+
     MPI_Finalize();
 
     return 0;
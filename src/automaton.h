@@ -8,6 +8,9 @@
 #include <mpi.h>
 
 #include "population_utils.h"
+#include "packed_population.h"
+#include "row_kernels.h"
+#include "tiled_population.h"
 #include "arg_parser.h"
 
 #define UP 0
@@ -18,11 +21,20 @@
 #define UPPER_THRESHOLD_RATIO 3.0 / 2.0
 #define LOWER_THRESHOLD_RATIO 2.0 / 3.0
 
+#define STAT_ALIVE 0
+#define STAT_DELTA 1
+#define STAT_HASH 2
+#define STAT_PREV_HASH 3
+#define STAT_COUNT 4
+
 #define CONTROLLER_RANK 0
 #define REORDER false
 
 
-const int PERIODICITY[] = {1, 0};
+// Halos swapped by a neighbourhood collective. Neighbours of cartesian communicator are ordered up, down, left, right.
+const int ALL_HALOS[] = {1, 1, 1, 1};
+const int ROW_HALOS[] = {1, 1, 0, 0};
+const int COLUMN_HALOS[] = {0, 0, 1, 1};
 
 
 /**
@@ -47,9 +59,44 @@ typedef struct {
     cell *down_recv;
     cell *left_recv;
     cell *right_recv;
+
+    MPI_Datatype row_type;
+    MPI_Datatype column_type;
+
+    MPI_Request collective_req;
+    MPI_Aint send_displs[4];
+    MPI_Aint recv_displs[4];
+    MPI_Datatype neighbour_types[4];
+
+    MPI_Win window;
+    MPI_Comm node_comm;
+    MPI_Request node_requests[8];
+    int node_request_count;
+    cell *window_base;
+    unsigned int window_cells;
+
+    cell *neighbour_base[4];
+    unsigned int neighbour_cells[4];
+    unsigned int neighbour_offset[4];
+    unsigned int neighbour_stride[4];
+
+    unsigned int halo_offset[4];
+    unsigned int halo_stride[4];
+    unsigned int halo_len[4];
+
+    MPI_Group neighbour_group;
+    int targets[4];
+    unsigned int boundary_offset[4];
+    MPI_Datatype target_types[4];
 } SwapBuffer;
 
 
+/**
+ * Queue of frames being written, defined in snapshot.h.
+ */
+typedef struct SnapshotQueue SnapshotQueue;
+
+
 /**
  * Container for simulation data.
  */
@@ -84,23 +131,118 @@ typedef struct {
     unsigned int local_augmented_width;
     unsigned int local_augmented_height;
 
+    unsigned int halo_depth;
+    unsigned int halo_step;
+
+    bool wrap_vertical;
+    bool wrap_horizontal;
+
+    int exchange;
     int rank;
 
+    // Cut positions of rows and columns of the process grid, which move when partitions are rebalanced.
+    int *row_cuts;
+    int *col_cuts;
+
+    // Time spent in steps, and in halo swaps within them, since partitions were last balanced.
+    double step_time;
+    double exchange_time;
+
     MPI_Comm comm;
     SwapBuffer *swap_buffer;
+    TileGrid *tile_grid;
+    SnapshotQueue *snapshot_queue;
     Arguments *args;
+
+    // Current step, and the step the run started from, which is not 0 if restarted from a checkpoint.
+    unsigned int step;
+    unsigned int start_step;
+    bool count_stats;
+
+    // Ring of global live cell counts and hashes of past stats steps, searched for a repeated population.
+    unsigned long long *cycle_history;
+    unsigned int cycle_count;
+
+    row_kernel update_row_fn_ptr;
+    row_kernel uncounted_row_fn_ptr;
+    packed_kernel update_packed_fn_ptr;
+    packed_kernel uncounted_packed_fn_ptr;
 } SimulationData;
 
 
 /**
- * Initializes swap buffer struct.
+ * Allocates requests and statuses of swap buffer and initializes all MPI handles, so that only those used by the
+ * exchange backend are freed.
+ *
+ * @param buf   SwapBuffer struct.
+ */
+void init_swap_handles(SwapBuffer *buf) {
+    buf->recv_buf = malloc(4 * sizeof(MPI_Request));
+    buf->send_buf = malloc(4 * sizeof(MPI_Request));
+
+    buf->recv_status_buf = malloc(4 * sizeof(MPI_Status));
+    buf->send_status_buf = malloc(4 * sizeof(MPI_Status));
+
+    // Requests must be initialized in case only some of the halos are swapped.
+    for (int i = 0; i < 4; i++) {
+        buf->recv_buf[i] = MPI_REQUEST_NULL;
+        buf->send_buf[i] = MPI_REQUEST_NULL;
+        buf->target_types[i] = MPI_DATATYPE_NULL;
+    }
+
+    buf->collective_req = MPI_REQUEST_NULL;
+
+    buf->row_type = MPI_DATATYPE_NULL;
+    buf->column_type = MPI_DATATYPE_NULL;
+
+    buf->window = MPI_WIN_NULL;
+    buf->node_comm = MPI_COMM_NULL;
+    buf->node_request_count = 0;
+    buf->neighbour_group = MPI_GROUP_NULL;
+}
+
+
+/**
+ * Creates persistent requests that swap a single halo with a neighbouring process. Messages are tagged with the
+ * direction of the halo they fill, so halos are matched correctly even if the same process is the neighbour on both
+ * sides.
+ *
+ * @param buf       SwapBuffer struct.
+ * @param recv      Receiving buffer.
+ * @param send      Sending buffer.
+ * @param halo_len  Halo length.
+ * @param target    Target rank.
+ * @param direction Direction of the target.
+ * @param comm      Communicator.
+ */
+void init_persistent_swap(
+        SwapBuffer *buf,
+        cell *recv,
+        cell *send,
+        unsigned int halo_len,
+        int target,
+        int direction,
+        MPI_Comm comm
+) {
+    MPI_Recv_init(recv, halo_len, MPI_CELL, target, direction, comm, &(buf->recv_buf[direction]));
+    MPI_Send_init(send, halo_len, MPI_CELL, target, (direction + 2) % 4, comm, &(buf->send_buf[direction]));
+}
+
+
+/**
+ * Initializes swap buffer struct. Halo buffers never move, so the exchange is built once as persistent requests that
+ * are started every step.
  *
- * @param halo_width    Halo width.
- * @param halo_height   Halo height.
+ * @param halo_width    Number of cells in upper and lower halo.
+ * @param halo_height   Number of cells in left and right halo.
+ * @param neighbours    Neighbour ranks indexed by direction.
+ * @param comm          Communicator.
  * @return              SwapBuffer struct with allocated buffers.
  */
-SwapBuffer *init_swap_buffer(unsigned int halo_width, unsigned int halo_height) {
-    SwapBuffer *buf = malloc(sizeof(SwapBuffer));
+SwapBuffer *init_swap_buffer(unsigned int halo_width, unsigned int halo_height, const int *neighbours, MPI_Comm comm) {
+    SwapBuffer *buf = calloc(1, sizeof(SwapBuffer));
+
+    init_swap_handles(buf);
 
     buf->halo_width = halo_width;
     buf->halo_height = halo_height;
@@ -116,11 +258,61 @@ SwapBuffer *init_swap_buffer(unsigned int halo_width, unsigned int halo_height)
     buf->left_recv = calloc(halo_height, sizeof(cell));
     buf->right_recv = calloc(halo_height, sizeof(cell));
 
-    buf->recv_buf = malloc(4 * sizeof(MPI_Request));
-    buf->send_buf = malloc(4 * sizeof(MPI_Request));
+    init_persistent_swap(buf, buf->up_recv, buf->up_send, halo_width, neighbours[UP], UP, comm);
+    init_persistent_swap(buf, buf->left_recv, buf->left_send, halo_height, neighbours[LEFT], LEFT, comm);
+    init_persistent_swap(buf, buf->down_recv, buf->down_send, halo_width, neighbours[DOWN], DOWN, comm);
+    init_persistent_swap(buf, buf->right_recv, buf->right_send, halo_height, neighbours[RIGHT], RIGHT, comm);
 
-    buf->recv_status_buf = malloc(4 * sizeof(MPI_Status));
-    buf->send_status_buf = malloc(4 * sizeof(MPI_Status));
+    return buf;
+}
+
+
+/**
+ * Initializes swap buffer struct for zero-copy halo exchange. Halos are described by derived datatypes over the
+ * augmented population, so messages are sent and received in-place and no halo buffers are allocated.
+ *
+ * @param halo_depth    Halo depth.
+ * @param local_height  Height of the local population.
+ * @param local_width   Width of the local population.
+ * @return              SwapBuffer struct with committed datatypes.
+ */
+SwapBuffer *init_datatype_swap_buffer(unsigned int halo_depth, unsigned int local_height, unsigned int local_width) {
+    SwapBuffer *buf = calloc(1, sizeof(SwapBuffer));
+
+    init_swap_handles(buf);
+
+    unsigned int augmented_width = local_width + 2 * halo_depth;
+
+    // Each halo is a single element of a derived datatype.
+    buf->halo_width = 1;
+    buf->halo_height = 1;
+
+    // Deep halos are swapped in two phases, so upper and lower halos span the whole augmented width.
+    MPI_Type_contiguous((halo_depth == 1) ? local_width : halo_depth * augmented_width, MPI_CELL, &buf->row_type);
+    MPI_Type_vector(local_height, halo_depth, augmented_width, MPI_CELL, &buf->column_type);
+
+    MPI_Type_commit(&buf->row_type);
+    MPI_Type_commit(&buf->column_type);
+
+    // Byte displacements of halos used by neighbourhood collectives, in the order of cartesian neighbours. Sends are
+    // displaced from the first row of the local population, so that send and receive buffers don't alias.
+    unsigned int k = halo_depth;
+    unsigned int offset = (halo_depth == 1) ? 1 : 0;
+
+    buf->recv_displs[0] = offset * sizeof(cell);
+    buf->recv_displs[1] = ((local_height + k) * augmented_width + offset) * sizeof(cell);
+    buf->recv_displs[2] = (k * augmented_width) * sizeof(cell);
+    buf->recv_displs[3] = (k * augmented_width + augmented_width - k) * sizeof(cell);
+
+    buf->send_displs[0] = offset * sizeof(cell);
+    buf->send_displs[1] = ((local_height - k) * augmented_width + offset) * sizeof(cell);
+    buf->send_displs[2] = k * sizeof(cell);
+    buf->send_displs[3] = (augmented_width - 2 * k) * sizeof(cell);
+
+    buf->neighbour_types[0] = buf->row_type;
+    buf->neighbour_types[1] = buf->row_type;
+    buf->neighbour_types[2] = buf->column_type;
+    buf->neighbour_types[3] = buf->column_type;
 
     return buf;
 }
@@ -132,6 +324,17 @@ SwapBuffer *init_swap_buffer(unsigned int halo_width, unsigned int halo_height)
  * @param buf   SwapBuffer to be freed.
  */
 void free_swap_buffer(SwapBuffer *buf) {
+    // Persistent requests stay allocated after completion.
+    for (int i = 0; i < 4; i++) {
+        if (buf->recv_buf[i] != MPI_REQUEST_NULL) {
+            MPI_Request_free(&(buf->recv_buf[i]));
+        }
+
+        if (buf->send_buf[i] != MPI_REQUEST_NULL) {
+            MPI_Request_free(&(buf->send_buf[i]));
+        }
+    }
+
     free(buf->recv_buf);
     free(buf->send_buf);
     free(buf->recv_status_buf);
@@ -144,6 +347,35 @@ void free_swap_buffer(SwapBuffer *buf) {
     free(buf->down_recv);
     free(buf->left_recv);
     free(buf->right_recv);
+
+    if (buf->row_type != MPI_DATATYPE_NULL) {
+        MPI_Type_free(&buf->row_type);
+        MPI_Type_free(&buf->column_type);
+    }
+
+    if (buf->window != MPI_WIN_NULL) {
+        // Shared windows are locked for their whole lifetime.
+        if (buf->node_comm != MPI_COMM_NULL) {
+            for (int i = 0; i < buf->node_request_count; i++) {
+                MPI_Request_free(&buf->node_requests[i]);
+            }
+
+            MPI_Win_unlock_all(buf->window);
+            MPI_Comm_free(&buf->node_comm);
+        }
+
+        MPI_Win_free(&buf->window);
+    }
+
+    if (buf->neighbour_group != MPI_GROUP_NULL) {
+        MPI_Group_free(&buf->neighbour_group);
+    }
+
+    // Upper and lower targets share row type.
+    if (buf->target_types[LEFT] != MPI_DATATYPE_NULL) {
+        MPI_Type_free(&buf->target_types[LEFT]);
+        MPI_Type_free(&buf->target_types[RIGHT]);
+    }
 }
 
 
@@ -173,7 +405,8 @@ inline bool check_upper_threshold(unsigned long long live_cells, unsigned long l
 
 /**
  * Computes vertical/horizontal side length for a given position in 2d grid of processes. If given length doesn't
- * divide by the number of processes, last process handles the remainder.
+ * divide by the number of processes, the remainder is spread over the first processes, so that side lengths differ by
+ * at most one.
  *
  * @param length    Side length.
  * @param pos       Position/rank of the process.
@@ -181,7 +414,394 @@ inline bool check_upper_threshold(unsigned long long live_cells, unsigned long l
  * @return
  */
 int get_side_length(int length, int pos, int n) {
-    return (pos + 1 == n) ? length - (floor(length / n) * (n - 1)) : floor(length / n);
+    return length / n + (pos < length % n);
+}
+
+
+/**
+ * Initializes uniform cut positions of rows or columns of the process grid. Partition at position pos spans
+ * [cuts[pos], cuts[pos + 1]).
+ *
+ * @param length    Side length.
+ * @param n         Number of rows/columns.
+ * @param cuts      Cut positions, n + 1 elements.
+ */
+void init_cuts(int length, int n, int *cuts) {
+    cuts[0] = 0;
+
+    for (int i = 0; i < n; i++) {
+        cuts[i + 1] = cuts[i] + get_side_length(length, i, n);
+    }
+}
+
+
+/**
+ * Computes cost of a process grid as the halo perimeter of the largest partition.
+ *
+ * @param rows      Number of rows of the process grid.
+ * @param cols      Number of columns of the process grid.
+ * @param height    Height of the global population.
+ * @param width     Width of the global population.
+ * @return          Halo perimeter of the largest partition.
+ */
+static inline long get_grid_cost(int rows, int cols, int height, int width) {
+    return 2L * (get_side_length(height, 0, rows) + get_side_length(width, 0, cols));
+}
+
+
+/**
+ * Chooses shape of the process grid for a given population. Unlike MPI_Dims_create, which only balances the number of
+ * processes along each dimension, this picks the factorization of n_proc minimizing the halo perimeter of the largest
+ * partition, so that elongated populations are split along their long side. Ties are broken in favour of more rows,
+ * which matches MPI_Dims_create on square populations. Factorizations leaving empty partitions are skipped.
+ *
+ * @param n_proc    Number of processes.
+ * @param height    Height of the global population.
+ * @param width     Width of the global population.
+ * @param shape     Shape of the process grid, {0, 0} if there is no valid shape.
+ */
+void create_process_grid(int n_proc, int height, int width, int *shape) {
+    long cost, best = -1;
+
+    shape[0] = 0;
+    shape[1] = 0;
+
+    for (int rows = n_proc; rows >= 1; rows--) {
+        if (n_proc % rows != 0 || rows > height || n_proc / rows > width) {
+            continue;
+        }
+
+        cost = get_grid_cost(rows, n_proc / rows, height, width);
+
+        if (best < 0 || cost < best) {
+            best = cost;
+            shape[0] = rows;
+            shape[1] = n_proc / rows;
+        }
+    }
+}
+
+
+/**
+ * Computes shape of the population of a given process.
+ *
+ * @param topology      Cartesian communicator.
+ * @param shape         Shape of the process grid.
+ * @param global_height Height of the global population.
+ * @param global_width  Width of the global population.
+ * @param rank          Rank of the process.
+ * @param height        Height of the population of the process.
+ * @param width         Width of the population of the process.
+ */
+void get_partition_shape(
+        MPI_Comm topology,
+        const int *shape,
+        int global_height,
+        int global_width,
+        int rank,
+        unsigned int *height,
+        unsigned int *width
+) {
+    int coordinates[2];
+
+    MPI_Cart_coords(topology, rank, 2, coordinates);
+
+    *height = get_side_length(global_height, coordinates[0], shape[0]);
+    *width = get_side_length(global_width, coordinates[1], shape[1]);
+}
+
+
+/**
+ * Initializes swap buffer struct for halo exchange through shared memory. Both generations of cells are allocated in a
+ * shared window on each node, so that halos of neighbours on the same node are read directly from their populations.
+ * Halos of neighbours on other nodes are swapped with persistent point-to-point requests.
+ *
+ * @param topology      Cartesian communicator.
+ * @param shape         Shape of the process grid.
+ * @param neighbours    Neighbour ranks indexed by direction.
+ * @param global_height Height of the global population.
+ * @param global_width  Width of the global population.
+ * @param local_height  Height of the local population.
+ * @param local_width   Width of the local population.
+ * @return              SwapBuffer struct with allocated window.
+ */
+SwapBuffer *init_shared_swap_buffer(
+        MPI_Comm topology,
+        const int *shape,
+        const int *neighbours,
+        int global_height,
+        int global_width,
+        unsigned int local_height,
+        unsigned int local_width
+) {
+    MPI_Comm node_comm;
+    MPI_Group group, node_group;
+    MPI_Info info;
+    MPI_Win window;
+    MPI_Aint size;
+
+    int disp_unit, node_ranks[4], remote_neighbours[4];
+    unsigned int width = local_width + 2, height = local_height + 2, neighbour_height, neighbour_width;
+    cell *base;
+
+    MPI_Comm_split_type(topology, MPI_COMM_TYPE_SHARED, 0, MPI_INFO_NULL, &node_comm);
+
+    // Each process keeps its generations in its own pages, so they are placed close to it.
+    MPI_Info_create(&info);
+    MPI_Info_set(info, "alloc_shared_noncontig", "true");
+    MPI_Win_allocate_shared(2 * height * width * sizeof(cell), sizeof(cell), info, node_comm, &base, &window);
+    MPI_Info_free(&info);
+
+    // Find which neighbours share the node.
+    MPI_Comm_group(topology, &group);
+    MPI_Comm_group(node_comm, &node_group);
+    MPI_Group_translate_ranks(group, 4, neighbours, node_group, node_ranks);
+    MPI_Group_free(&group);
+    MPI_Group_free(&node_group);
+
+    for (int i = 0; i < 4; i++) {
+        bool on_node = node_ranks[i] != MPI_UNDEFINED && node_ranks[i] != MPI_PROC_NULL;
+        remote_neighbours[i] = on_node ? MPI_PROC_NULL : neighbours[i];
+    }
+
+    SwapBuffer *buf = init_swap_buffer(local_width, local_height, remote_neighbours, topology);
+
+    buf->window = window;
+    buf->node_comm = node_comm;
+    buf->window_base = base;
+    buf->window_cells = height * width;
+
+    // Halos of this process.
+    buf->halo_offset[UP] = 1;
+    buf->halo_offset[DOWN] = (height - 1) * width + 1;
+    buf->halo_offset[LEFT] = width;
+    buf->halo_offset[RIGHT] = 2 * width - 1;
+
+    buf->halo_stride[UP] = buf->halo_stride[DOWN] = 1;
+    buf->halo_stride[LEFT] = buf->halo_stride[RIGHT] = width;
+
+    buf->halo_len[UP] = buf->halo_len[DOWN] = local_width;
+    buf->halo_len[LEFT] = buf->halo_len[RIGHT] = local_height;
+
+    // Boundaries of neighbours on the same node, which are read into halos of this process.
+    for (int i = 0; i < 4; i++) {
+        if (remote_neighbours[i] != MPI_PROC_NULL || neighbours[i] == MPI_PROC_NULL) {
+            continue;
+        }
+
+        MPI_Win_shared_query(window, node_ranks[i], &size, &disp_unit, &(buf->neighbour_base[i]));
+        get_partition_shape(topology, shape, global_height, global_width, neighbours[i], &neighbour_height,
+                            &neighbour_width);
+
+        neighbour_width += 2;
+
+        buf->neighbour_cells[i] = (neighbour_height + 2) * neighbour_width;
+        buf->neighbour_stride[i] = (i == UP || i == DOWN) ? 1 : neighbour_width;
+
+        switch (i) {
+            case UP:
+                buf->neighbour_offset[i] = neighbour_height * neighbour_width + 1;
+                break;
+            case LEFT:
+                buf->neighbour_offset[i] = 2 * neighbour_width - 2;
+                break;
+            default:
+                buf->neighbour_offset[i] = neighbour_width + 1;
+        }
+    }
+
+    // Neighbours on the same node signal each other with empty messages once they finish writing a generation. Each
+    // neighbour is signalled once, even if it borders this process from several directions.
+    int node_rank;
+    MPI_Comm_rank(node_comm, &node_rank);
+
+    for (int i = 0; i < 4; i++) {
+        bool seen = !buf->neighbour_base[i] || node_ranks[i] == node_rank;
+
+        for (int j = 0; j < i && !seen; j++) {
+            seen = buf->neighbour_base[j] && node_ranks[j] == node_ranks[i];
+        }
+
+        if (seen) {
+            continue;
+        }
+
+        MPI_Recv_init(NULL, 0, MPI_BYTE, node_ranks[i], 0, node_comm, &buf->node_requests[buf->node_request_count++]);
+        MPI_Send_init(NULL, 0, MPI_BYTE, node_ranks[i], 0, node_comm, &buf->node_requests[buf->node_request_count++]);
+    }
+
+    MPI_Win_lock_all(MPI_MODE_NOCHECK, window);
+
+    return buf;
+}
+
+
+/**
+ * Initializes swap buffer struct for one-sided halo exchange. Both generations of cells are allocated in a window,
+ * and processes put their boundaries directly into halos of their neighbours.
+ *
+ * @param topology      Cartesian communicator.
+ * @param shape         Shape of the process grid.
+ * @param neighbours    Neighbour ranks indexed by direction.
+ * @param global_height Height of the global population.
+ * @param global_width  Width of the global population.
+ * @param local_height  Height of the local population.
+ * @param local_width   Width of the local population.
+ * @return              SwapBuffer struct with allocated window.
+ */
+SwapBuffer *init_rma_swap_buffer(
+        MPI_Comm topology,
+        const int *shape,
+        const int *neighbours,
+        int global_height,
+        int global_width,
+        unsigned int local_height,
+        unsigned int local_width
+) {
+    MPI_Group group;
+
+    int n_neighbours = 0, group_ranks[4];
+    unsigned int width = local_width + 2, height = local_height + 2, neighbour_height, neighbour_width;
+
+    SwapBuffer *buf = calloc(1, sizeof(SwapBuffer));
+
+    init_swap_handles(buf);
+
+    MPI_Win_allocate(2 * height * width * sizeof(cell), sizeof(cell), MPI_INFO_NULL, topology, &(buf->window_base),
+                     &(buf->window));
+
+    buf->window_cells = height * width;
+
+    MPI_Type_contiguous(local_width, MPI_CELL, &buf->row_type);
+    MPI_Type_vector(local_height, 1, width, MPI_CELL, &buf->column_type);
+
+    MPI_Type_commit(&buf->row_type);
+    MPI_Type_commit(&buf->column_type);
+
+    // Boundaries of this process, which are put into halos of neighbours.
+    buf->boundary_offset[UP] = width + 1;
+    buf->boundary_offset[DOWN] = local_height * width + 1;
+    buf->boundary_offset[LEFT] = width + 1;
+    buf->boundary_offset[RIGHT] = width + local_width;
+
+    for (int i = 0; i < 4; i++) {
+        buf->targets[i] = neighbours[i];
+
+        if (neighbours[i] == MPI_PROC_NULL) {
+            continue;
+        }
+
+        get_partition_shape(topology, shape, global_height, global_width, neighbours[i], &neighbour_height,
+                            &neighbour_width);
+
+        neighbour_width += 2;
+
+        buf->neighbour_cells[i] = (neighbour_height + 2) * neighbour_width;
+        buf->neighbour_stride[i] = neighbour_width;
+
+        // Boundaries fill halos on the opposite side of neighbours.
+        switch (i) {
+            case UP:
+                buf->neighbour_offset[i] = (neighbour_height + 1) * neighbour_width + 1;
+                break;
+            case DOWN:
+                buf->neighbour_offset[i] = 1;
+                break;
+            case LEFT:
+                buf->neighbour_offset[i] = 2 * neighbour_width - 1;
+                break;
+            default:
+                buf->neighbour_offset[i] = neighbour_width;
+        }
+
+        // Each process appears in the neighbour group once, even if it is a neighbour on both sides.
+        bool duplicate = false;
+
+        for (int j = 0; j < n_neighbours; j++) {
+            duplicate = duplicate || group_ranks[j] == neighbours[i];
+        }
+
+        if (!duplicate) {
+            group_ranks[n_neighbours++] = neighbours[i];
+        }
+    }
+
+    // Left and right neighbours have the same height, but their own width.
+    buf->target_types[UP] = buf->row_type;
+    buf->target_types[DOWN] = buf->row_type;
+
+    MPI_Type_vector(local_height, 1, buf->neighbour_stride[LEFT], MPI_CELL, &buf->target_types[LEFT]);
+    MPI_Type_vector(local_height, 1, buf->neighbour_stride[RIGHT], MPI_CELL, &buf->target_types[RIGHT]);
+
+    MPI_Type_commit(&buf->target_types[LEFT]);
+    MPI_Type_commit(&buf->target_types[RIGHT]);
+
+    MPI_Comm_group(topology, &group);
+    MPI_Group_incl(group, n_neighbours, group_ranks, &buf->neighbour_group);
+    MPI_Group_free(&group);
+
+    return buf;
+}
+
+
+/**
+ * Checks whether some process is both the upper and lower, or both the left and right neighbour, which happens along
+ * periodic dimensions of one or two processes. MPI implementations don't agree on how neighbourhood collectives match
+ * messages between such neighbours.
+ *
+ * @param shape     Shape of the process grid.
+ * @param periods   Periodicity of each dimension.
+ * @return          True if process grid has duplicate neighbours, otherwise false.
+ */
+static inline bool has_duplicate_neighbours(const int *shape, const int *periods) {
+    return (periods[0] && shape[0] <= 2) || (periods[1] && shape[1] <= 2);
+}
+
+
+/**
+ * Initializes swap buffer of a given halo exchange backend.
+ *
+ * @param topology      Cartesian communicator.
+ * @param shape         Shape of the process grid.
+ * @param neighbours    Neighbour ranks indexed by direction.
+ * @param args          Arguments struct.
+ * @param exchange      Halo exchange backend.
+ * @param local_height  Height of the local population.
+ * @param local_width   Width of the local population.
+ * @return              SwapBuffer struct.
+ */
+SwapBuffer *init_exchange_swap_buffer(
+        MPI_Comm topology,
+        const int *shape,
+        const int *neighbours,
+        Arguments *args,
+        int exchange,
+        unsigned int local_height,
+        unsigned int local_width
+) {
+    unsigned int local_augmented_width = local_width + 2 * args->halo_depth;
+
+    if (exchange == EXCHANGE_RMA) {
+        return init_rma_swap_buffer(topology, shape, neighbours, args->height, args->width, local_height,
+                                    local_width);
+    }
+
+    if (exchange == EXCHANGE_SHARED) {
+        return init_shared_swap_buffer(topology, shape, neighbours, args->height, args->width, local_height,
+                                       local_width);
+    }
+
+    if (exchange == EXCHANGE_DATATYPE || exchange == EXCHANGE_NEIGHBOUR) {
+        return init_datatype_swap_buffer(args->halo_depth, local_height, local_width);
+    }
+
+    if (args->halo_depth == 1) {
+        return init_swap_buffer(local_width, local_height, neighbours, topology);
+    }
+
+    // Deep halos are swapped in two phases, so upper and lower halos include corners.
+    return init_swap_buffer(args->halo_depth * local_augmented_width, args->halo_depth * local_height, neighbours,
+                            topology);
 }
 
 
@@ -194,36 +814,79 @@ int get_side_length(int length, int pos, int n) {
 SimulationData init_simulation_data(Arguments *args) {
     MPI_Comm topology;
 
-    int n_proc, left_neighbour, right_neighbour, upper_neighbour, lower_neighbour, rank, local_width, local_height, local_augmented_width, local_augmented_height;
+    int n_proc, rank, local_width, local_height, local_augmented_width, local_augmented_height;
 
     int shape[2] = {0, 0};
     int coordinates[2] = {0, 0};
+    int neighbours[4];
 
     MPI_Comm_rank(MPI_COMM_WORLD, &rank);
     MPI_Comm_size(MPI_COMM_WORLD, &n_proc);
 
 
     // Compute grid shape and create cartesian topology.
-    MPI_Dims_create(n_proc, 2, shape);
-    MPI_Cart_create(MPI_COMM_WORLD, 2, shape, PERIODICITY, REORDER, &topology);
+    create_process_grid(n_proc, args->height, args->width, shape);
+
+    if (shape[0] == 0) {
+        if (rank == CONTROLLER_RANK) {
+            fprintf(stderr, "automaton: population [%d, %d] cannot be split between %d processes\n", args->height,
+                    args->width, n_proc);
+        }
+
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+
+    MPI_Cart_create(MPI_COMM_WORLD, 2, shape, args->periods, REORDER, &topology);
 
     // Find neighbours.
-    MPI_Cart_shift(topology, 1, -1, &rank, &left_neighbour);
-    MPI_Cart_shift(topology, 1, 1, &rank, &right_neighbour);
-    MPI_Cart_shift(topology, 0, -1, &rank, &upper_neighbour);
-    MPI_Cart_shift(topology, 0, 1, &rank, &lower_neighbour);
+    MPI_Cart_shift(topology, 1, 1, &neighbours[LEFT], &neighbours[RIGHT]);
+    MPI_Cart_shift(topology, 0, 1, &neighbours[UP], &neighbours[DOWN]);
+
+    // Halos along periodic dimensions spanned by this process alone are wrapped in memory rather than sent to itself.
+    bool wrap_vertical = neighbours[UP] == rank;
+    bool wrap_horizontal = neighbours[LEFT] == rank;
+
+    for (int i = 0; i < 4; i++) {
+        if (neighbours[i] == rank) {
+            neighbours[i] = MPI_PROC_NULL;
+        }
+    }
 
     // Find cartesian coordinates of this process.
     MPI_Cart_coords(topology, rank, 2, coordinates);
 
     // Compute population shape.
-    local_width = get_side_length(args->length, coordinates[1], shape[1]);
-    local_height = get_side_length(args->length, coordinates[0], shape[0]);
+    local_width = get_side_length(args->width, coordinates[1], shape[1]);
+    local_height = get_side_length(args->height, coordinates[0], shape[0]);
+
+    if (args->halo_depth > local_width || args->halo_depth > local_height) {
+        if (rank == CONTROLLER_RANK) {
+            fprintf(stderr, "automaton: halo depth %d exceeds partition shape [%d, %d]\n", args->halo_depth,
+                    local_height, local_width);
+        }
 
-    local_augmented_width = local_width + 2;
-    local_augmented_height = local_height + 2;
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+
+    local_augmented_width = local_width + 2 * args->halo_depth;
+    local_augmented_height = local_height + 2 * args->halo_depth;
+
+    // Fall back to point-to-point exchange of derived datatypes, which tags halos with their direction.
+    int exchange = args->exchange;
+
+    if (exchange == EXCHANGE_NEIGHBOUR && has_duplicate_neighbours(shape, args->periods)) {
+        exchange = EXCHANGE_DATATYPE;
+    }
+
+    SwapBuffer *swap_buffer = init_exchange_swap_buffer(topology, shape, neighbours, args, exchange, local_height,
+                                                        local_width);
 
-    SwapBuffer *swap_buffer = init_swap_buffer(local_width, local_height);
+    // Partitions start with uniform cut positions.
+    int *row_cuts = malloc((shape[0] + 1) * sizeof(int));
+    int *col_cuts = malloc((shape[1] + 1) * sizeof(int));
+
+    init_cuts(args->height, shape[0], row_cuts);
+    init_cuts(args->width, shape[1], col_cuts);
 
     SimulationData data = {
             .args                           = args,
@@ -234,195 +897,1027 @@ SimulationData init_simulation_data(Arguments *args) {
             .n_proc                         = n_proc,
             .global_seed                    = args->seed,
             .swap_buffer                    = swap_buffer,
+            .row_cuts                       = row_cuts,
+            .col_cuts                       = col_cuts,
+            .step_time                      = 0,
+            .exchange_time                  = 0,
+            .tile_grid                      = args->tile_size > 0
+                                              ? init_tile_grid(local_augmented_height, local_augmented_width,
+                                                               args->tile_size, args->halo_depth, args->activity)
+                                              : NULL,
+            .snapshot_queue                 = NULL,
             .x_coordinate                   = coordinates[0],
             .y_coordinate                   = coordinates[1],
             .local_width                    = local_width,
             .local_height                   = local_height,
-            .left_neighbour                 = left_neighbour,
-            .right_neighbour                = right_neighbour,
-            .upper_neighbour                = upper_neighbour,
-            .lower_neighbour                = lower_neighbour,
+            .left_neighbour                 = neighbours[LEFT],
+            .right_neighbour                = neighbours[RIGHT],
+            .upper_neighbour                = neighbours[UP],
+            .lower_neighbour                = neighbours[DOWN],
             .local_augmented_width          = local_augmented_width,
             .local_augmented_height         = local_augmented_height,
+            .halo_depth                     = args->halo_depth,
+            .halo_step                      = 0,
+            .wrap_vertical                  = wrap_vertical,
+            .wrap_horizontal                = wrap_horizontal,
+            .exchange                       = exchange,
+            .step                           = 0,
+            .start_step                     = 0,
+            .count_stats                    = true,
+            .cycle_history                  = args->cycle_window > 0
+                                              ? malloc(2 * args->cycle_window * sizeof(unsigned long long))
+                                              : NULL,
+            .cycle_count                    = 0,
+            .update_row_fn_ptr              = select_row_kernel(args->rule),
+            .uncounted_row_fn_ptr           = select_row_kernel_variant(args->rule, false),
+            .update_packed_fn_ptr           = packed_kernels[args->rule],
+            .uncounted_packed_fn_ptr        = uncounted_packed_kernels[args->rule],
     };
 
     return data;
 }
 
 /**
- * Higher-order helper function that handles non-blocking communications for halo swapping logic.
+ * Helper function that handles non-blocking communications for halo swapping logic. It is used when halos are swapped
+ * in-place, since the population alternates between generations and persistent requests can't be bound to it.
+ * Messages are tagged with the direction of the halo they fill, like persistent swaps.
  *
- * @param pop               Population of cells.
  * @param recv              Receiving buffer.
  * @param send              Sending buffer.
- * @param halo_len          Halo length.
- * @param height            Local augmented height of a partition.
- * @param width             Local augmented width of a partition.
+ * @param halo_len          Halo length in elements of the given type.
+ * @param type              Halo element datatype.
  * @param target            Target rank.
+ * @param direction         Direction of the target.
  * @param recv_req          Receive request buffer.
  * @param send_req          Send request buffer.
  * @param comm              Communicator.
- * @param copy_halo_fn_ptr  Function that handles halo copying.
  */
 inline void swap_halo(
-        cell *pop,
         cell *recv,
         cell *send,
         unsigned int halo_len,
-        unsigned int height,
-        unsigned int width,
+        MPI_Datatype type,
         int target,
+        int direction,
         MPI_Request *recv_req,
         MPI_Request *send_req,
-        MPI_Comm comm,
-        void (*copy_halo_fn_ptr)(cell *, cell *, unsigned int, unsigned int)
+        MPI_Comm comm
 ) {
-    MPI_Irecv(recv, halo_len, MPI_CELL, target, MPI_ANY_TAG, comm, recv_req);   // Start receiving message
-    copy_halo_fn_ptr(pop, send, height, width);                                 // Copy halo into send buffer.
-    MPI_Issend(send, halo_len, MPI_CELL, target, 0, comm, send_req);            // Start sending message.
+    // Start receiving message.
+    MPI_Irecv(recv, halo_len, type, target, direction, comm, recv_req);
+    // Start sending message, which fills the halo on the opposite side of the target.
+    MPI_Isend(send, halo_len, type, target, (direction + 2) % 4, comm, send_req);
 }
 
 
 /**
- * Swaps halos between processes.
+ * Starts exchanging halos stored in send buffers with neighbouring processes.
  *
- * @param pop   Population of cells.
  * @param buf   SwapBuffer struct.
- * @param sim   SimulationData struct.
  */
-void swap_halos(cell *pop, SwapBuffer *buf, SimulationData *sim) {
-    // Swap upper halos.
-    swap_halo(
-            pop,
-            buf->up_recv,
-            buf->up_send,
-            buf->halo_width,
-            sim->local_augmented_height,
-            sim->local_augmented_width,
-            sim->upper_neighbour,
-            &(buf->recv_buf[UP]),
-            &(buf->send_buf[UP]),
-            sim->comm,
-            &copy_upper_halo
-    );
-    // Swap left halos.
-    swap_halo(
-            pop,
-            buf->left_recv,
-            buf->left_send,
-            buf->halo_height,
-            sim->local_augmented_height,
-            sim->local_augmented_width,
-            sim->left_neighbour,
-            &(buf->recv_buf[LEFT]),
-            &(buf->send_buf[LEFT]),
-            sim->comm,
-            &copy_left_halo
-    );
-    // Swap lower halos.
-    swap_halo(
-            pop,
-            buf->down_recv,
-            buf->down_send,
-            buf->halo_width,
-            sim->local_augmented_height,
-            sim->local_augmented_width,
-            sim->lower_neighbour,
-            &(buf->recv_buf[DOWN]),
-            &(buf->send_buf[DOWN]),
-            sim->comm,
-            &copy_lower_halo
-    );
-    swap_halo(
-            pop,
-            buf->right_recv,
-            buf->right_send,
-            buf->halo_height,
-            sim->local_augmented_height,
-            sim->local_augmented_width,
-            sim->right_neighbour,
-            &(buf->recv_buf[RIGHT]),
-            &(buf->send_buf[RIGHT]),
-            sim->comm,
-            &copy_right_halo
-    );
+void post_halo_swaps(SwapBuffer *buf) {
+    // Receives are started first, so that messages don't have to be buffered.
+    MPI_Startall(4, buf->recv_buf);
+    MPI_Startall(4, buf->send_buf);
+}
 
-    MPI_Waitall(4, buf->recv_buf, buf->recv_status_buf);    // Receive.
-    MPI_Waitall(4, buf->send_buf, buf->send_status_buf);    // Send.
 
-    // Insert halos.
-    insert_left_halo(pop, buf->left_recv, sim->local_augmented_width, buf->halo_height);
-    insert_right_halo(pop, buf->right_recv, sim->local_augmented_width, buf->halo_height);
-    insert_upper_halo(pop, buf->up_recv, sim->local_augmented_width, buf->halo_height);
-    insert_lower_halo(pop, buf->down_recv, sim->local_augmented_height, sim->local_augmented_width, buf->halo_height);
+/**
+ * Starts persistent requests that swap halos with a neighbour in a single direction.
+ *
+ * @param buf       SwapBuffer struct.
+ * @param direction Direction of the neighbour.
+ */
+void post_halo_swap(SwapBuffer *buf, int direction) {
+    MPI_Start(&(buf->recv_buf[direction]));
+    MPI_Start(&(buf->send_buf[direction]));
 }
 
 
 /**
- * Initializes random seeds in-place for processes.
+ * Waits until all posted halo swaps complete.
  *
- * @param seed  Initial seed.
- * @param n     Number of seeds to generate.
- * @param seeds Seeds buffer.
+ * @param buf   SwapBuffer struct.
  */
-void init_seeds(int seed, int n, int *seeds) {
-    srand(seed);
-
-    for (int i = 0; i < n; i++) {
-        seeds[i] = rand();
-    }
+void wait_halo_swaps(SwapBuffer *buf) {
+    MPI_Waitall(4, buf->recv_buf, buf->recv_status_buf);    // Receive.
+    MPI_Waitall(4, buf->send_buf, buf->send_status_buf);    // Send.
+    MPI_Wait(&(buf->collective_req), MPI_STATUS_IGNORE);    // Neighbourhood collective.
 }
 
 
 /**
- * Prints worker data.
+ * Exchanges halos stored in send buffers with neighbouring processes. Received halos are stored in receive buffers.
  *
- * @param sim   SimulationData struct.
+ * @param buf   SwapBuffer struct.
  */
-inline void print_worker_data(SimulationData *sim) {
-    printf("automaton: rank = %d, shape = [%d, %d], coordinates = (%d, %d), seed = %u\n", sim->rank,
-           sim->local_height,
-           sim->local_width, sim->x_coordinate, sim->y_coordinate, sim->local_seed);
+void exchange_halos(SwapBuffer *buf) {
+    post_halo_swaps(buf);
+    wait_halo_swaps(buf);
 }
 
 
 /**
- * Prints simulation data.
+ * Wraps left and right halos in memory if this process is its own left and right neighbour. Must follow insertion of
+ * received halos, since halos of missing neighbours are overwritten with dead cells.
  *
+ * @param pop   Population of cells.
  * @param sim   SimulationData struct.
  */
-inline void print_simulation_data(SimulationData *sim) {
-    printf("automaton: L = %d, rho = %.5f, seed = %d, maxstep = %d\n", sim->args->length, sim->args->prob,
-           sim->local_seed, sim->args->max_steps);
+static inline void wrap_local_column_halos(cell *pop, SimulationData *sim) {
+    if (sim->wrap_horizontal) {
+        wrap_column_halos(pop, sim->local_augmented_height, sim->local_augmented_width, sim->halo_depth);
+    }
 }
 
 
 /**
- * Prints simulation statistics.
+ * Wraps upper and lower halos in memory if this process is its own upper and lower neighbour. Must follow insertion of
+ * received halos, since halos of missing neighbours are overwritten with dead cells.
  *
- * @param step                      Current step.
- * @param global_live_cell_count    Number of live cells in the population.
+ * @param pop   Population of cells.
+ * @param sim   SimulationData struct.
  */
-inline void
-print_interval_data(unsigned int step, unsigned long long global_live_cell_count, unsigned long long global_delta) {
-    printf("automaton: step = %u, live cells = %llu, delta = %llu\n", step, global_live_cell_count, global_delta);
+static inline void wrap_local_row_halos(cell *pop, SimulationData *sim) {
+    if (sim->wrap_vertical) {
+        wrap_row_halos(pop, sim->local_augmented_height, sim->local_augmented_width, sim->halo_depth);
+    }
 }
 
 
 /**
- * Prints information if lower threshold is reached.
+ * Starts exchanging left and right halos in-place using derived datatypes.
+ *
+ * @param pop   Population of cells.
+ * @param buf   SwapBuffer struct.
+ * @param sim   SimulationData struct.
  */
-inline void print_on_lower_threshold_touch() {
-    printf("automaton: global cell count dropped below lower threshold\n");
+void post_column_swaps(cell *pop, SwapBuffer *buf, SimulationData *sim) {
+    unsigned int k = sim->halo_depth;
+    unsigned int width = sim->local_augmented_width;
+
+    cell *first_row = pop + k * width;
+
+    swap_halo(first_row, first_row + k, 1, buf->column_type, sim->left_neighbour, LEFT,
+              &(buf->recv_buf[LEFT]), &(buf->send_buf[LEFT]), sim->comm);
+    swap_halo(first_row + width - k, first_row + width - 2 * k, 1, buf->column_type, sim->right_neighbour, RIGHT,
+              &(buf->recv_buf[RIGHT]), &(buf->send_buf[RIGHT]), sim->comm);
 }
 
 
 /**
- * Prints information if upper threshold is reached.
+ * Starts exchanging upper and lower halos in-place using derived datatypes.
+ *
+ * @param pop   Population of cells.
+ * @param buf   SwapBuffer struct.
+ * @param sim   SimulationData struct.
+ */
+void post_row_swaps(cell *pop, SwapBuffer *buf, SimulationData *sim) {
+    unsigned int k = sim->halo_depth;
+    unsigned int width = sim->local_augmented_width;
+
+    // Single-cell halos skip corners, deep halos span the whole augmented width.
+    cell *upper_halo = pop + ((k == 1) ? 1 : 0);
+    cell *lower_halo = upper_halo + (sim->local_augmented_height - k) * width;
+
+    swap_halo(upper_halo, upper_halo + k * width, 1, buf->row_type, sim->upper_neighbour, UP,
+              &(buf->recv_buf[UP]), &(buf->send_buf[UP]), sim->comm);
+    swap_halo(lower_halo, lower_halo - k * width, 1, buf->row_type, sim->lower_neighbour, DOWN,
+              &(buf->recv_buf[DOWN]), &(buf->send_buf[DOWN]), sim->comm);
+}
+
+
+/**
+ * Swaps deep halos between processes in-place using derived datatypes. Left and right halos are swapped before upper
+ * and lower halos, so that corners are propagated.
+ *
+ * @param pop   Population of cells.
+ * @param buf   SwapBuffer struct.
+ * @param sim   SimulationData struct.
+ */
+void swap_deep_datatype_halos(cell *pop, SwapBuffer *buf, SimulationData *sim) {
+    post_column_swaps(pop, buf, sim);
+    wait_halo_swaps(buf);
+    wrap_local_column_halos(pop, sim);
+
+    post_row_swaps(pop, buf, sim);
+    wait_halo_swaps(buf);
+    wrap_local_row_halos(pop, sim);
+}
+
+
+/**
+ * Starts exchanging halos in-place with a neighbourhood collective on the cartesian communicator.
+ *
+ * @param pop       Population of cells.
+ * @param buf       SwapBuffer struct.
+ * @param sim       SimulationData struct.
+ * @param counts    Number of halos swapped with each neighbour.
+ */
+void post_neighbour_swaps(cell *pop, SwapBuffer *buf, SimulationData *sim, const int *counts) {
+    cell *first_row = pop + sim->halo_depth * sim->local_augmented_width;
+
+    MPI_Ineighbor_alltoallw(first_row, counts, buf->send_displs, buf->neighbour_types,
+                            pop, counts, buf->recv_displs, buf->neighbour_types, sim->comm, &(buf->collective_req));
+}
+
+
+/**
+ * Swaps deep halos between processes in-place with neighbourhood collectives. Left and right halos are swapped before
+ * upper and lower halos, so that corners are propagated.
+ *
+ * @param pop   Population of cells.
+ * @param buf   SwapBuffer struct.
+ * @param sim   SimulationData struct.
+ */
+void swap_deep_neighbour_halos(cell *pop, SwapBuffer *buf, SimulationData *sim) {
+    post_neighbour_swaps(pop, buf, sim, COLUMN_HALOS);
+    wait_halo_swaps(buf);
+
+    post_neighbour_swaps(pop, buf, sim, ROW_HALOS);
+    wait_halo_swaps(buf);
+}
+
+
+/**
+ * Swaps deep halos between processes. Left and right halos are swapped first, then upper and lower halos are swapped
+ * across the whole augmented width, which propagates the corners needed for temporal blocking.
+ *
+ * @param pop   Population of cells.
+ * @param buf   SwapBuffer struct.
+ * @param sim   SimulationData struct.
+ */
+void swap_deep_halos(cell *pop, SwapBuffer *buf, SimulationData *sim) {
+    unsigned int k = sim->halo_depth;
+    unsigned int height = sim->local_augmented_height;
+    unsigned int width = sim->local_augmented_width;
+
+    // Swap left and right halos.
+    copy_block(pop, buf->left_send, width, sim->local_height, k, k, k);
+    copy_block(pop, buf->right_send, width, sim->local_height, k, k, width - 2 * k);
+
+    post_halo_swap(buf, LEFT);
+    post_halo_swap(buf, RIGHT);
+
+    wait_halo_swaps(buf);
+
+    insert_block(pop, buf->left_recv, width, sim->local_height, k, k, 0);
+    insert_block(pop, buf->right_recv, width, sim->local_height, k, k, width - k);
+    wrap_local_column_halos(pop, sim);
+
+    // Swap upper and lower halos, including corners.
+    copy_block(pop, buf->up_send, width, k, width, k, 0);
+    copy_block(pop, buf->down_send, width, k, width, height - 2 * k, 0);
+
+    post_halo_swap(buf, UP);
+    post_halo_swap(buf, DOWN);
+
+    wait_halo_swaps(buf);
+
+    insert_block(pop, buf->up_recv, width, k, width, 0, 0);
+    insert_block(pop, buf->down_recv, width, k, width, height - k, 0);
+    wrap_local_row_halos(pop, sim);
+}
+
+
+/**
+ * Starts swapping halos through shared memory. Halos of neighbours on other nodes are copied and posted as usual, then
+ * neighbours on the same node synchronize and their halos are read directly from their populations. A single
+ * synchronization per step suffices, since a neighbour only overwrites a generation after the next synchronization,
+ * which waits for this process to finish reading it.
+ *
+ * @param pop   Population of cells.
+ * @param buf   SwapBuffer struct.
+ * @param sim   SimulationData struct.
+ */
+void start_shared_halo_swap(cell *pop, SwapBuffer *buf, SimulationData *sim) {
+    unsigned int height = sim->local_augmented_height;
+    unsigned int width = sim->local_augmented_width;
+
+    // Copy halos of remote neighbours into send buffers.
+    if (!buf->neighbour_base[UP]) {
+        copy_upper_halo(pop, buf->up_send, height, width);
+    }
+
+    if (!buf->neighbour_base[LEFT]) {
+        copy_left_halo(pop, buf->left_send, height, width);
+    }
+
+    if (!buf->neighbour_base[DOWN]) {
+        copy_lower_halo(pop, buf->down_send, height, width);
+    }
+
+    if (!buf->neighbour_base[RIGHT]) {
+        copy_right_halo(pop, buf->right_send, height, width);
+    }
+
+    post_halo_swaps(buf);
+
+    // Wait until neighbours on the same node finish writing current generation.
+    MPI_Win_sync(buf->window);
+    MPI_Startall(buf->node_request_count, buf->node_requests);
+    MPI_Waitall(buf->node_request_count, buf->node_requests, MPI_STATUSES_IGNORE);
+    MPI_Win_sync(buf->window);
+
+    // Neighbours advance in lockstep, so their current generation has the same parity.
+    unsigned int parity = (pop == buf->window_base) ? 0 : 1;
+
+    for (int i = 0; i < 4; i++) {
+        if (!buf->neighbour_base[i]) {
+            continue;
+        }
+
+        cell *src = buf->neighbour_base[i] + parity * buf->neighbour_cells[i] + buf->neighbour_offset[i];
+        cell *dst = pop + buf->halo_offset[i];
+
+        for (unsigned int j = 0; j < buf->halo_len[i]; j++) {
+            dst[j * buf->halo_stride[i]] = src[j * buf->neighbour_stride[i]];
+        }
+    }
+}
+
+
+/**
+ * Finishes swapping halos through shared memory and inserts halos received from neighbours on other nodes.
+ *
+ * @param pop   Population of cells.
+ * @param buf   SwapBuffer struct.
+ * @param sim   SimulationData struct.
+ */
+void finish_shared_halo_swap(cell *pop, SwapBuffer *buf, SimulationData *sim) {
+    unsigned int height = sim->local_augmented_height;
+    unsigned int width = sim->local_augmented_width;
+
+    wait_halo_swaps(buf);
+
+    if (!buf->neighbour_base[LEFT]) {
+        insert_left_halo(pop, buf->left_recv, width, buf->halo_height);
+    }
+
+    if (!buf->neighbour_base[RIGHT]) {
+        insert_right_halo(pop, buf->right_recv, width, buf->halo_height);
+    }
+
+    if (!buf->neighbour_base[UP]) {
+        insert_upper_halo(pop, buf->up_recv, width, buf->halo_width);
+    }
+
+    if (!buf->neighbour_base[DOWN]) {
+        insert_lower_halo(pop, buf->down_recv, height, width, buf->halo_width);
+    }
+}
+
+
+/**
+ * Starts swapping halos with one-sided communication. Each process exposes its population to neighbours and puts its
+ * boundaries into their halos.
+ *
+ * @param pop   Population of cells.
+ * @param buf   SwapBuffer struct.
+ */
+void start_rma_halo_swap(cell *pop, SwapBuffer *buf) {
+    // Neighbours advance in lockstep, so their current generation has the same parity.
+    unsigned int parity = (pop == buf->window_base) ? 0 : 1;
+
+    MPI_Win_post(buf->neighbour_group, 0, buf->window);
+    MPI_Win_start(buf->neighbour_group, 0, buf->window);
+
+    for (int i = 0; i < 4; i++) {
+        if (buf->targets[i] == MPI_PROC_NULL) {
+            continue;
+        }
+
+        MPI_Put(pop + buf->boundary_offset[i], 1, (i == UP || i == DOWN) ? buf->row_type : buf->column_type,
+                buf->targets[i], parity * buf->neighbour_cells[i] + buf->neighbour_offset[i], 1, buf->target_types[i],
+                buf->window);
+    }
+}
+
+
+/**
+ * Finishes swapping halos with one-sided communication. Returns once boundaries of this process are put into halos of
+ * neighbours, and boundaries of neighbours are put into halos of this process.
+ *
+ * @param buf   SwapBuffer struct.
+ */
+void finish_rma_halo_swap(SwapBuffer *buf) {
+    MPI_Win_complete(buf->window);
+    MPI_Win_wait(buf->window);
+}
+
+
+/**
+ * Starts swapping halos between processes. Halos are copied into send buffers and non-blocking communications are
+ * posted, so that computation that doesn't depend on halos can proceed until finish_halo_swap is called.
+ *
+ * @param pop   Population of cells.
+ * @param buf   SwapBuffer struct.
+ * @param sim   SimulationData struct.
+ */
+void start_halo_swap(cell *pop, SwapBuffer *buf, SimulationData *sim) {
+    // Derived datatypes send and receive halos in-place.
+    if (sim->exchange == EXCHANGE_DATATYPE) {
+        post_row_swaps(pop, buf, sim);
+        post_column_swaps(pop, buf, sim);
+        return;
+    }
+
+    if (sim->exchange == EXCHANGE_NEIGHBOUR) {
+        post_neighbour_swaps(pop, buf, sim, ALL_HALOS);
+        return;
+    }
+
+    if (sim->exchange == EXCHANGE_SHARED) {
+        start_shared_halo_swap(pop, buf, sim);
+        return;
+    }
+
+    if (sim->exchange == EXCHANGE_RMA) {
+        start_rma_halo_swap(pop, buf);
+        return;
+    }
+
+    // Copy halos into send buffers.
+    copy_upper_halo(pop, buf->up_send, sim->local_augmented_height, sim->local_augmented_width);
+    copy_left_halo(pop, buf->left_send, sim->local_augmented_height, sim->local_augmented_width);
+    copy_lower_halo(pop, buf->down_send, sim->local_augmented_height, sim->local_augmented_width);
+    copy_right_halo(pop, buf->right_send, sim->local_augmented_height, sim->local_augmented_width);
+
+    post_halo_swaps(buf);
+}
+
+
+/**
+ * Finishes swapping halos started by start_halo_swap and inserts received halos into population.
+ *
+ * @param pop   Population of cells.
+ * @param buf   SwapBuffer struct.
+ * @param sim   SimulationData struct.
+ */
+void finish_halo_swap(cell *pop, SwapBuffer *buf, SimulationData *sim) {
+    if (sim->exchange == EXCHANGE_SHARED) {
+        finish_shared_halo_swap(pop, buf, sim);
+    } else if (sim->exchange == EXCHANGE_RMA) {
+        finish_rma_halo_swap(buf);
+    } else {
+        wait_halo_swaps(buf);
+    }
+
+    if (sim->exchange == EXCHANGE_P2P) {
+        // Insert halos.
+        insert_left_halo(pop, buf->left_recv, sim->local_augmented_width, buf->halo_height);
+        insert_right_halo(pop, buf->right_recv, sim->local_augmented_width, buf->halo_height);
+        insert_upper_halo(pop, buf->up_recv, sim->local_augmented_width, buf->halo_width);
+        insert_lower_halo(pop, buf->down_recv, sim->local_augmented_height, sim->local_augmented_width,
+                          buf->halo_width);
+    }
+
+    wrap_local_column_halos(pop, sim);
+    wrap_local_row_halos(pop, sim);
+}
+
+
+/**
+ * Swaps halos between processes. Time spent swapping is recorded, so that it's not mistaken for computation when
+ * partitions are rebalanced.
+ *
+ * @param pop   Population of cells.
+ * @param buf   SwapBuffer struct.
+ * @param sim   SimulationData struct.
+ */
+void swap_halos(cell *pop, SwapBuffer *buf, SimulationData *sim) {
+    double start = MPI_Wtime();
+
+    if (sim->halo_depth == 1) {
+        start_halo_swap(pop, buf, sim);
+        finish_halo_swap(pop, buf, sim);
+    } else {
+        switch (sim->exchange) {
+            case EXCHANGE_DATATYPE:
+                swap_deep_datatype_halos(pop, buf, sim);
+                break;
+            case EXCHANGE_NEIGHBOUR:
+                swap_deep_neighbour_halos(pop, buf, sim);
+                break;
+            default:
+                swap_deep_halos(pop, buf, sim);
+        }
+    }
+
+    sim->exchange_time += MPI_Wtime() - start;
+}
+
+
+/**
+ * Swaps halos of packed population between processes. Halos travel as cells, so packed and unpacked processes use the
+ * same messages.
+ *
+ * @param pop   Packed population of cells.
+ * @param buf   SwapBuffer struct.
+ * @param sim   SimulationData struct.
+ */
+void swap_packed_halos(cell_word *pop, SwapBuffer *buf, SimulationData *sim) {
+    // Copy halos into send buffers.
+    copy_packed_upper_halo(pop, buf->up_send, sim->local_augmented_height, sim->local_augmented_width);
+    copy_packed_left_halo(pop, buf->left_send, sim->local_augmented_height, sim->local_augmented_width);
+    copy_packed_lower_halo(pop, buf->down_send, sim->local_augmented_height, sim->local_augmented_width);
+    copy_packed_right_halo(pop, buf->right_send, sim->local_augmented_height, sim->local_augmented_width);
+
+    exchange_halos(buf);
+
+    insert_packed_halos(pop, buf->up_recv, buf->down_recv, buf->left_recv, buf->right_recv,
+                        sim->local_augmented_height, sim->local_augmented_width);
+
+    if (sim->wrap_horizontal) {
+        wrap_packed_column_halos(pop, sim->local_augmented_height, sim->local_augmented_width);
+    }
+
+    if (sim->wrap_vertical) {
+        wrap_packed_row_halos(pop, sim->local_augmented_height, sim->local_augmented_width);
+    }
+}
+
+
+/**
+ * Returns row kernel for the current step. Live and changed cells are only counted on steps that report statistics.
+ *
+ * @param sim   SimulationData struct.
+ * @return      Row kernel.
+ */
+static inline row_kernel get_row_kernel(SimulationData *sim) {
+    return sim->count_stats ? sim->update_row_fn_ptr : sim->uncounted_row_fn_ptr;
+}
+
+
+/**
+ * Returns packed kernel for the current step. Live and changed cells are only counted on steps that report statistics.
+ *
+ * @param sim   SimulationData struct.
+ * @return      Packed kernel.
+ */
+static inline packed_kernel get_packed_kernel(SimulationData *sim) {
+    return sim->count_stats ? sim->update_packed_fn_ptr : sim->uncounted_packed_fn_ptr;
+}
+
+
+/**
+ * Advances population of cells by a single generation.
+ *
+ * @param sim               SimulationData struct.
+ * @param fst_generation    Current generation of cells.
+ * @param snd_generation    Buffer that will contain next generation of cells.
+ * @param cells_alive       Number of live cells in the next generation.
+ * @param cells_delta       Number of cells that changed state.
+ */
+void step_population(
+        SimulationData *sim,
+        void *fst_generation,
+        void *snd_generation,
+        unsigned long long *cells_alive,
+        unsigned long long *cells_delta
+) {
+    swap_halos(fst_generation, sim->swap_buffer, sim);
+
+    update_population_rows(
+            fst_generation,
+            snd_generation,
+            cells_alive,
+            cells_delta,
+            sim->local_augmented_height,
+            sim->local_augmented_width,
+            get_row_kernel(sim)
+    );
+}
+
+
+/**
+ * Advances population of cells by a single generation, overlapping halo swap with computation. Interior cells that
+ * don't depend on halos are computed while halos are in flight, and the one-cell boundary ring is computed once they
+ * arrive.
+ *
+ * @param sim               SimulationData struct.
+ * @param fst_generation    Current generation of cells.
+ * @param snd_generation    Buffer that will contain next generation of cells.
+ * @param cells_alive       Number of live cells in the next generation.
+ * @param cells_delta       Number of cells that changed state.
+ */
+void step_overlapped_population(
+        SimulationData *sim,
+        void *fst_generation,
+        void *snd_generation,
+        unsigned long long *cells_alive,
+        unsigned long long *cells_delta
+) {
+    unsigned long long interior_alive, interior_delta, ring_alive, ring_delta;
+    double start = MPI_Wtime();
+
+    start_halo_swap(fst_generation, sim->swap_buffer, sim);
+
+    sim->exchange_time += MPI_Wtime() - start;
+
+    update_population_interior(
+            fst_generation,
+            snd_generation,
+            &interior_alive,
+            &interior_delta,
+            sim->local_augmented_height,
+            sim->local_augmented_width,
+            get_row_kernel(sim)
+    );
+
+    start = MPI_Wtime();
+
+    finish_halo_swap(fst_generation, sim->swap_buffer, sim);
+
+    sim->exchange_time += MPI_Wtime() - start;
+
+    update_population_ring(
+            fst_generation,
+            snd_generation,
+            &ring_alive,
+            &ring_delta,
+            sim->local_augmented_height,
+            sim->local_augmented_width,
+            get_row_kernel(sim)
+    );
+
+    *cells_alive = interior_alive + ring_alive;
+    *cells_delta = interior_delta + ring_delta;
+}
+
+
+/**
+ * Computes how far from the edge of the augmented population the next generation can be computed. Halos are valid
+ * right after the swap and shrink by one cell every step; halos that are never swapped stay dead and are not computed.
+ *
+ * @param sim       SimulationData struct.
+ * @param neighbour Neighbour on the side of interest.
+ * @param wrapped   Whether halo on the side of interest is wrapped in memory.
+ * @param halo_step Number of steps since the last halo swap.
+ * @return          Margin.
+ */
+static inline unsigned int get_halo_margin(SimulationData *sim, int neighbour, bool wrapped, unsigned int halo_step) {
+    return (neighbour != MPI_PROC_NULL || wrapped) ? halo_step + 1 : sim->halo_depth;
+}
+
+
+/**
+ * Computes region of the augmented population that can be computed a given number of steps after the last halo swap.
+ *
+ * @param sim       SimulationData struct.
+ * @param halo_step Number of steps since the last halo swap.
+ * @param kernel    Row kernel.
+ * @return          StepRegion struct.
+ */
+static inline StepRegion get_step_region(SimulationData *sim, unsigned int halo_step, row_kernel kernel) {
+    StepRegion region = {
+            .top                = get_halo_margin(sim, sim->upper_neighbour, sim->wrap_vertical, halo_step),
+            .bottom             = sim->local_augmented_height -
+                                  get_halo_margin(sim, sim->lower_neighbour, sim->wrap_vertical, halo_step),
+            .left               = get_halo_margin(sim, sim->left_neighbour, sim->wrap_horizontal, halo_step),
+            .right              = sim->local_augmented_width -
+                                  get_halo_margin(sim, sim->right_neighbour, sim->wrap_horizontal, halo_step),
+            .update_row_fn_ptr  = kernel,
+    };
+
+    return region;
+}
+
+
+/**
+ * Advances population of cells with deep halos by a single generation. Halos are swapped once every halo_depth steps,
+ * and halo cells are recomputed redundantly in between.
+ *
+ * @param sim               SimulationData struct.
+ * @param fst_generation    Current generation of cells.
+ * @param snd_generation    Buffer that will contain next generation of cells.
+ * @param cells_alive       Number of live cells in the next generation.
+ * @param cells_delta       Number of cells that changed state.
+ */
+void step_deep_population(
+        SimulationData *sim,
+        void *fst_generation,
+        void *snd_generation,
+        unsigned long long *cells_alive,
+        unsigned long long *cells_delta
+) {
+    if (sim->halo_step == 0) {
+        swap_halos(fst_generation, sim->swap_buffer, sim);
+    }
+
+    StepRegion region = get_step_region(sim, sim->halo_step, get_row_kernel(sim));
+
+    update_population_region(
+            fst_generation,
+            snd_generation,
+            cells_alive,
+            cells_delta,
+            sim->local_augmented_height,
+            sim->local_augmented_width,
+            sim->halo_depth,
+            region.top,
+            region.bottom,
+            region.left,
+            region.right,
+            region.update_row_fn_ptr
+    );
+
+    sim->halo_step = (sim->halo_step + 1) % sim->halo_depth;
+}
+
+
+/**
+ * Checks if the generation computed by a step may be read by the step loop before the next halo swap. With early
+ * stopping or cycle detection, the run may end after any step, generations of checksum steps are hashed, and frames
+ * are written after every frame interval steps.
+ *
+ * @param sim   SimulationData struct.
+ * @param step  Step number.
+ * @return      True if generation of the step is read, otherwise false.
+ */
+static inline bool is_observed_step(SimulationData *sim, unsigned int step) {
+    return sim->args->early_stopping || sim->args->cycle_window > 0 ||
+           (sim->args->checksum_interval > 0 && step % sim->args->checksum_interval == 0) ||
+           (sim->args->frame_interval > 0 && (step + 1) % sim->args->frame_interval == 0);
+}
+
+
+/**
+ * Computes number of steps computed by the next task graph of tiles. Task graphs span steps up to the next halo swap or
+ * the last step, but end early at steps whose generation is read, since the two buffers only hold the last two
+ * generations of a task graph.
+ *
+ * @param sim   SimulationData struct.
+ * @return      Number of steps.
+ */
+static inline unsigned int get_tile_block_len(SimulationData *sim) {
+    unsigned int block_len = sim->halo_depth - sim->halo_step;
+
+    if (block_len > sim->args->max_steps - sim->step) {
+        block_len = sim->args->max_steps - sim->step;
+    }
+
+    for (unsigned int j = 0; j + 1 < block_len; j++) {
+        if (is_observed_step(sim, sim->step + j)) {
+            return j + 1;
+        }
+    }
+
+    return block_len;
+}
+
+
+/**
+ * Advances population of cells by a single generation using tiles scheduled as tasks. All steps of a block, see
+ * get_tile_block_len, are computed by a single task graph on the first call, and later calls only return stats of
+ * their step. With activity tracking, tiles next to halos that differ from the ones they replaced are marked as
+ * changed.
+ *
+ * @param sim               SimulationData struct.
+ * @param fst_generation    Current generation of cells.
+ * @param snd_generation    Buffer that will contain next generation of cells.
+ * @param cells_alive       Number of live cells in the next generation.
+ * @param cells_delta       Number of cells that changed state.
+ */
+void step_tiled_population(
+        SimulationData *sim,
+        void *fst_generation,
+        void *snd_generation,
+        unsigned long long *cells_alive,
+        unsigned long long *cells_delta
+) {
+    TileGrid *grid = sim->tile_grid;
+
+    if (grid->block_step == grid->block_len) {
+        StepRegion regions[grid->max_steps];
+        unsigned int block_len = get_tile_block_len(sim);
+
+        if (sim->halo_step == 0) {
+            if (grid->track_activity) {
+                save_halo_ring(grid, fst_generation, sim->local_augmented_height, sim->local_augmented_width);
+            }
+
+            swap_halos(fst_generation, sim->swap_buffer, sim);
+
+            if (grid->track_activity) {
+                mark_changed_halos(grid, fst_generation, sim->local_augmented_height, sim->local_augmented_width);
+            }
+        }
+
+        for (unsigned int j = 0; j < block_len; j++) {
+            // Activity is tracked with counted kernels, since skipped tiles are found from changed cells.
+            bool count = grid->track_activity || (sim->step + j) % sim->args->stats_interval == 0;
+
+            regions[j] = get_step_region(sim, sim->halo_step + j,
+                                         count ? sim->update_row_fn_ptr : sim->uncounted_row_fn_ptr);
+        }
+
+        update_population_tiles(grid, fst_generation, snd_generation, sim->local_augmented_height,
+                                sim->local_augmented_width, sim->halo_depth, regions, block_len);
+
+        grid->block_len = block_len;
+        grid->block_step = 0;
+    }
+
+    *cells_alive = grid->step_alive[grid->block_step];
+    *cells_delta = grid->step_delta[grid->block_step];
+
+    grid->block_step++;
+    sim->halo_step = (sim->halo_step + 1) % sim->halo_depth;
+}
+
+
+/**
+ * Advances packed population of cells by a single generation.
+ *
+ * @param sim               SimulationData struct.
+ * @param fst_generation    Current packed generation of cells.
+ * @param snd_generation    Packed buffer that will contain next generation of cells.
+ * @param cells_alive       Number of live cells in the next generation.
+ * @param cells_delta       Number of cells that changed state.
+ */
+void step_packed_population(
+        SimulationData *sim,
+        void *fst_generation,
+        void *snd_generation,
+        unsigned long long *cells_alive,
+        unsigned long long *cells_delta
+) {
+    swap_packed_halos(fst_generation, sim->swap_buffer, sim);
+
+    get_packed_kernel(sim)(
+            fst_generation,
+            snd_generation,
+            cells_alive,
+            cells_delta,
+            sim->local_augmented_height,
+            sim->local_augmented_width
+    );
+}
+
+
+/**
+ * Computes position-aware hash of the local population, so that hashes of all processes add up to the hash of the
+ * global population.
+ *
+ * @param sim           Simulation data.
+ * @param generation    Local generation of cells.
+ * @return              Local population hash.
+ */
+unsigned long long hash_local_population(SimulationData *sim, void *generation) {
+    unsigned int row_offset = sim->row_cuts[sim->x_coordinate];
+    unsigned int col_offset = sim->col_cuts[sim->y_coordinate];
+
+    if (sim->args->packed) {
+        return hash_packed_population(generation, sim->local_augmented_height, sim->local_augmented_width, row_offset,
+                                      col_offset, sim->args->width);
+    }
+
+    return hash_population(generation, sim->local_augmented_height, sim->local_augmented_width, sim->halo_depth,
+                           row_offset, col_offset, sim->args->width);
+}
+
+
+/**
+ * Checks whether population hash is needed at a given stats step, either to detect cycles or to print a checksum.
+ *
+ * @param sim   Simulation data.
+ * @param step  Step number.
+ * @return      True if hash should be computed, otherwise false.
+ */
+static inline bool is_hash_step(SimulationData *sim, unsigned int step) {
+    return sim->args->cycle_window > 0 || (sim->args->checksum_interval > 0 && step % sim->args->checksum_interval == 0);
+}
+
+
+/**
+ * Searches past stats steps for a population equal to the current one and records the current population. Populations
+ * are compared by global live cell count and hash. Only stats steps are recorded, so with stats interval greater than
+ * one the detected period is a multiple of the actual period. Populations equal to the previous generation are fixed
+ * points, with period 1. Delta can't tell them apart, since it counts cells that differ from two generations earlier.
+ *
+ * @param sim   Simulation data.
+ * @param stats Global live cell count, delta and hash.
+ * @return      Period in steps, or 0 if population has not been seen within the window.
+ */
+unsigned int find_cycle(SimulationData *sim, const unsigned long long *stats) {
+    unsigned int window = sim->args->cycle_window;
+    unsigned int period = 0;
+
+    for (unsigned int j = 1; j <= window && j <= sim->cycle_count; j++) {
+        unsigned long long *entry = &sim->cycle_history[2 * ((sim->cycle_count - j) % window)];
+
+        if (entry[0] == stats[STAT_ALIVE] && entry[1] == stats[STAT_HASH]) {
+            period = j * sim->args->stats_interval;
+            break;
+        }
+    }
+
+    if (stats[STAT_HASH] == stats[STAT_PREV_HASH]) {
+        period = 1;
+    }
+
+    unsigned long long *entry = &sim->cycle_history[2 * (sim->cycle_count % window)];
+
+    entry[0] = stats[STAT_ALIVE];
+    entry[1] = stats[STAT_HASH];
+    sim->cycle_count++;
+
+    return period;
+}
+
+
+/**
+ * Prints worker data.
+ *
+ * @param sim   SimulationData struct.
+ */
+inline void print_worker_data(SimulationData *sim) {
+    printf("automaton: rank = %d, shape = [%d, %d], coordinates = (%d, %d), seed = %u\n", sim->rank,
+           sim->local_height,
+           sim->local_width, sim->x_coordinate, sim->y_coordinate, sim->local_seed);
+}
+
+
+/**
+ * Prints simulation data.
+ *
+ * @param sim   SimulationData struct.
+ */
+inline void print_simulation_data(SimulationData *sim) {
+    printf("automaton: H = %d, W = %d, rho = %.5f, seed = %d, maxstep = %d\n", sim->args->height, sim->args->width,
+           sim->args->prob, sim->local_seed, sim->args->max_steps);
+}
+
+
+/**
+ * Prints kernel used to compute next generation.
+ *
+ * @param sim   SimulationData struct.
+ */
+static inline void print_kernel_data(SimulationData *sim) {
+    char rule[2 * (MAX_STATE_SUM + 1)];
+
+    format_rule(sim->args->rule, rule);
+
+    printf("automaton: kernel = %s, rule = %s, exchange = %s, threads = %d\n",
+           sim->args->packed ? "packed" : get_row_kernel_name(sim->update_row_fn_ptr), rule,
+           exchange_names[sim->exchange], get_thread_count());
+}
+
+
+/**
+ * Prints simulation statistics.
+ *
+ * @param step                      Current step.
+ * @param global_live_cell_count    Number of live cells in the population.
+ */
+inline void
+print_interval_data(unsigned int step, unsigned long long global_live_cell_count, unsigned long long global_delta) {
+    printf("automaton: step = %u, live cells = %llu, delta = %llu\n", step, global_live_cell_count, global_delta);
+}
+
+
+/**
+ * Prints information if lower threshold is reached.
+ */
+inline void print_on_lower_threshold_touch() {
+    printf("automaton: global cell count dropped below lower threshold\n");
+}
+
+
+/**
+ * Prints information if upper threshold is reached.
  */
 static inline void print_on_upper_threshold_touch() {
     printf("automaton: global cell count exceeded upper threshold\n");
 }
 
 
+/**
+ * Prints global population checksum, which doesn't depend on the decomposition, so that runs can be compared.
+ *
+ * @param step      Current step.
+ * @param checksum  Global population hash.
+ */
+static inline void print_checksum(unsigned int step, unsigned long long checksum) {
+    printf("automaton: step = %u, checksum = %016llx\n", step, checksum);
+}
+
+
+/**
+ * Prints information if population repeats itself.
+ *
+ * @param step      Step at which the population repeated.
+ * @param period    Period of the cycle in steps.
+ */
+static inline void print_on_cycle(unsigned int step, unsigned int period) {
+    if (period == 1) {
+        printf("automaton: step = %u, population reached a fixed point\n", step);
+    } else {
+        printf("automaton: step = %u, population entered a cycle of period %u\n", step, period);
+    }
+}
+
+
 #endif //MPP_AUTOMATON_AUTOMATON_H
@@ -0,0 +1,233 @@
+#ifndef MPP_AUTOMATON_CHECKPOINT_H
+#define MPP_AUTOMATON_CHECKPOINT_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <mpi.h>
+
+#include "automaton.h"
+#include "packed_population.h"
+#include "io.h"
+
+
+/**
+ * Checkpoints are written to a temporary file next to the checkpoint first, and renamed once complete, so that a run
+ * killed while writing a checkpoint leaves the previous one intact.
+ */
+#define CHECKPOINT_TMP_SUFFIX ".tmp"
+
+/**
+ * Maximum length of checkpoint header.
+ */
+#define CHECKPOINT_HEADER_LEN 256
+
+/**
+ * Fields of checkpoint header broadcast by the controller.
+ */
+#define CHECKPOINT_VALID 0
+#define CHECKPOINT_STEP 1
+#define CHECKPOINT_LOWER 2
+#define CHECKPOINT_UPPER 3
+#define CHECKPOINT_WIDTH 4
+#define CHECKPOINT_HEIGHT 5
+#define CHECKPOINT_OFFSET 6
+#define CHECKPOINT_FIELDS 7
+
+
+/**
+ * Returns cells of a local generation, unpacking packed generations into a new buffer.
+ *
+ * @param sim           Simulation data.
+ * @param generation    Local generation of cells.
+ * @param halo          Halo depth of returned cells.
+ * @return              Local population of cells, to be freed with free_generation_cells.
+ */
+cell *get_generation_cells(SimulationData *sim, void *generation, unsigned int *halo) {
+    if (!sim->args->packed) {
+        *halo = sim->halo_depth;
+        return generation;
+    }
+
+    cell *population = malloc(sim->local_augmented_height * sim->local_augmented_width * sizeof(cell));
+    unpack_population(generation, population, sim->local_augmented_height, sim->local_augmented_width);
+
+    *halo = 1;
+    return population;
+}
+
+/**
+ * Frees cells returned by get_generation_cells.
+ *
+ * @param sim           Simulation data.
+ * @param population    Local population of cells.
+ */
+void free_generation_cells(SimulationData *sim, cell *population) {
+    if (sim->args->packed) {
+        free(population);
+    }
+}
+
+/**
+ * Saves both generations to a checkpoint with collective MPI-IO. Checkpoint holds two binary PBM images of the global
+ * population, the current and the previous generation, so that deltas of the restarted run are exact. The header of the
+ * first image carries the step to resume from and the early stopping thresholds. Images don't depend on the
+ * decomposition, so the run can be restarted on any number of processes.
+ *
+ * @param sim               Simulation data.
+ * @param fst_generation    Current generation of cells.
+ * @param snd_generation    Previous generation of cells.
+ * @param step              Next step to be computed.
+ */
+void write_checkpoint(SimulationData *sim, void *fst_generation, void *snd_generation, unsigned int step) {
+    MPI_File file;
+
+    MPI_Offset image_size = get_pbm_image_size(sim);
+    unsigned int halo;
+
+    char *filename = sim->args->checkpoint_file;
+    char *tmp_filename = malloc(strlen(filename) + sizeof(CHECKPOINT_TMP_SUFFIX));
+    sprintf(tmp_filename, "%s%s", filename, CHECKPOINT_TMP_SUFFIX);
+
+    char fst_header[CHECKPOINT_HEADER_LEN], snd_header[CHECKPOINT_HEADER_LEN];
+
+    int fst_len = snprintf(fst_header, CHECKPOINT_HEADER_LEN, "P4\n# checkpoint step %u lower %llu upper %llu\n%d %d\n",
+                           step, sim->lower_early_stopping_threshold, sim->upper_early_stopping_threshold,
+                           sim->args->width, sim->args->height);
+    int snd_len = snprintf(snd_header, CHECKPOINT_HEADER_LEN, "P4\n%d %d\n", sim->args->width, sim->args->height);
+
+    MPI_File_open(sim->comm, tmp_filename, MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL, &file);
+    MPI_File_set_size(file, fst_len + image_size + snd_len + image_size);
+
+    if (sim->rank == CONTROLLER_RANK) {
+        MPI_File_write_at(file, 0, fst_header, fst_len, MPI_CHAR, MPI_STATUS_IGNORE);
+        MPI_File_write_at(file, fst_len + image_size, snd_header, snd_len, MPI_CHAR, MPI_STATUS_IGNORE);
+    }
+
+    cell *population = get_generation_cells(sim, fst_generation, &halo);
+    write_global_pbm_pixels(file, fst_len, sim, population, halo);
+    free_generation_cells(sim, population);
+
+    population = get_generation_cells(sim, snd_generation, &halo);
+    write_global_pbm_pixels(file, fst_len + image_size + snd_len, sim, population, halo);
+    free_generation_cells(sim, population);
+
+    MPI_File_close(&file);
+
+    if (sim->rank == CONTROLLER_RANK) {
+        rename(tmp_filename, filename);
+        printf("automaton: step = %u, saved checkpoint to %s\n", step, filename);
+    }
+
+    free(tmp_filename);
+}
+
+/**
+ * Parses header of the first image of a checkpoint. Fields of headers that don't match are zero.
+ *
+ * @param buf       Null-terminated beginning of the checkpoint.
+ * @param fields    Parsed header fields.
+ */
+void parse_checkpoint_header(const char *buf, unsigned long long *fields) {
+    unsigned int step = 0;
+    int width = 0, height = 0, len = 0;
+
+    fields[CHECKPOINT_LOWER] = fields[CHECKPOINT_UPPER] = 0;
+    fields[CHECKPOINT_VALID] = sscanf(buf, "P4\n# checkpoint step %u lower %llu upper %llu\n%d %d%n", &step,
+                                      &fields[CHECKPOINT_LOWER], &fields[CHECKPOINT_UPPER], &width, &height, &len) == 5
+                               && buf[len] == '\n';
+
+    fields[CHECKPOINT_STEP] = step;
+    fields[CHECKPOINT_WIDTH] = width;
+    fields[CHECKPOINT_HEIGHT] = height;
+
+    // Pixels follow the single newline after the header.
+    fields[CHECKPOINT_OFFSET] = len + 1;
+}
+
+/**
+ * Restores both generations, the step to resume from and early stopping thresholds from a checkpoint. The header is
+ * parsed by the controller and broadcast, and every process reads its own partition of both images with collective
+ * MPI-IO. Halos are left for the first halo swap.
+ *
+ * @param sim               Simulation data.
+ * @param filename          Checkpoint filename.
+ * @param fst_generation    Buffer for the current generation of cells.
+ * @param snd_generation    Buffer for the previous generation of cells.
+ * @return                  Global live cell count of the current generation.
+ */
+unsigned long long read_checkpoint(SimulationData *sim, char *filename, void *fst_generation, void *snd_generation) {
+    MPI_File file;
+
+    unsigned long long fields[CHECKPOINT_FIELDS] = {0};
+
+    if (MPI_File_open(sim->comm, filename, MPI_MODE_RDONLY, MPI_INFO_NULL, &file) != MPI_SUCCESS) {
+        if (sim->rank == CONTROLLER_RANK) {
+            fprintf(stderr, "automaton: checkpoint %s cannot be opened\n", filename);
+        }
+
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+
+    if (sim->rank == CONTROLLER_RANK) {
+        char buf[CHECKPOINT_HEADER_LEN + 1] = {0};
+
+        MPI_File_read_at(file, 0, buf, CHECKPOINT_HEADER_LEN, MPI_CHAR, MPI_STATUS_IGNORE);
+        parse_checkpoint_header(buf, fields);
+    }
+
+    MPI_Bcast(fields, CHECKPOINT_FIELDS, MPI_UNSIGNED_LONG_LONG, CONTROLLER_RANK, sim->comm);
+
+    if (!fields[CHECKPOINT_VALID] || fields[CHECKPOINT_WIDTH] != sim->args->width ||
+        fields[CHECKPOINT_HEIGHT] != sim->args->height) {
+        if (sim->rank == CONTROLLER_RANK) {
+            fprintf(stderr, "automaton: %s is not a checkpoint of population [%d, %d]\n", filename, sim->args->height,
+                    sim->args->width);
+        }
+
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+
+    MPI_Offset image_size = get_pbm_image_size(sim);
+    MPI_Offset snd_offset = fields[CHECKPOINT_OFFSET] + image_size +
+                            snprintf(NULL, 0, "P4\n%d %d\n", sim->args->width, sim->args->height);
+
+    unsigned long long local_live_cell_count = 0, live_cell_count;
+
+    if (sim->args->packed) {
+        unsigned int n_cells = sim->local_augmented_height * sim->local_augmented_width;
+        cell *population = calloc(n_cells, sizeof(cell));
+
+        read_global_pbm_pixels(file, fields[CHECKPOINT_OFFSET], sim, population, 1);
+        pack_population(population, fst_generation, sim->local_augmented_height, sim->local_augmented_width);
+
+        for (unsigned int i = 0; i < n_cells; i++) {
+            local_live_cell_count += population[i];
+        }
+
+        read_global_pbm_pixels(file, snd_offset, sim, population, 1);
+        pack_population(population, snd_generation, sim->local_augmented_height, sim->local_augmented_width);
+
+        free(population);
+    } else {
+        read_global_pbm_pixels(file, fields[CHECKPOINT_OFFSET], sim, fst_generation, sim->halo_depth);
+        read_global_pbm_pixels(file, snd_offset, sim, snd_generation, sim->halo_depth);
+
+        local_live_cell_count = count_live_cells(fst_generation, sim->local_augmented_height,
+                                                 sim->local_augmented_width, sim->halo_depth);
+    }
+
+    MPI_File_close(&file);
+
+    MPI_Allreduce(&local_live_cell_count, &live_cell_count, 1, MPI_UNSIGNED_LONG_LONG, MPI_SUM, sim->comm);
+
+    sim->start_step = fields[CHECKPOINT_STEP];
+    sim->lower_early_stopping_threshold = fields[CHECKPOINT_LOWER];
+    sim->upper_early_stopping_threshold = fields[CHECKPOINT_UPPER];
+
+    return live_cell_count;
+}
+
+
+#endif //MPP_AUTOMATON_CHECKPOINT_H
@@ -14,11 +14,12 @@
  * @param buf       Target array.
  * @param height    Array height.
  * @param width     Array width.
+ * @param halo      Halo depth.
  * @param value     Constant to be used.
  */
-void generate_constant_population(cell *buf, int height, int width, cell value) {
-    for (int i = 1; i < height - 1; i++) {
-        for (int j = 1; j < width - 1; j++) {
+void generate_constant_population(cell *buf, int height, int width, int halo, cell value) {
+    for (int i = halo; i < height - halo; i++) {
+        for (int j = halo; j < width - halo; j++) {
             buf[i * width + j] = value;
         }
     }
@@ -32,8 +33,9 @@ void generate_constant_population(cell *buf, int height, int width, cell value)
  * @param sim   SimulationData struct.
  */
 void generate_reset_and_swap(cell *pop, SimulationData *sim) {
-    generate_constant_population(pop, sim->local_augmented_height, sim->local_augmented_width, sim->rank);
-    reset_halos(pop, sim->local_augmented_height, sim->local_augmented_width);
+    generate_constant_population(pop, sim->local_augmented_height, sim->local_augmented_width, sim->halo_depth,
+                                 sim->rank);
+    reset_halos(pop, sim->local_augmented_height, sim->local_augmented_width, sim->halo_depth);
 
     swap_halos(pop, sim->swap_buffer, sim);
 }
@@ -49,10 +51,29 @@ void generate_reset_and_swap(cell *pop, SimulationData *sim) {
  * @param sim   SimulationData struct.
  */
 void copy_halos(cell *pop, cell *up, cell *down, cell *left, cell *right, SimulationData *sim) {
-    copy_row(pop, up, sim->local_augmented_width, sim->local_width, 0, 1);
-    copy_row(pop, down, sim->local_augmented_width, sim->local_width, sim->local_augmented_height - 1, 1);
-    copy_column(pop, left, sim->local_augmented_width, sim->local_width, 0, 1);
-    copy_column(pop, right, sim->local_augmented_width, sim->local_width, sim->local_augmented_width - 1, 1);
+    unsigned int k = sim->halo_depth;
+
+    copy_block(pop, up, sim->local_augmented_width, k, sim->local_width, 0, k);
+    copy_block(pop, down, sim->local_augmented_width, k, sim->local_width, sim->local_augmented_height - k, k);
+    copy_block(pop, left, sim->local_augmented_width, sim->local_height, k, k, 0);
+    copy_block(pop, right, sim->local_augmented_width, sim->local_height, k, k, sim->local_augmented_width - k);
+}
+
+/**
+ * Checks that a corner of the halo is equal to value.
+ *
+ * @param pop   Population of cells.
+ * @param row   First row of the corner.
+ * @param col   First column of the corner.
+ * @param value Expected value.
+ * @param sim   SimulationData struct.
+ */
+void check_corner(cell *pop, unsigned int row, unsigned int col, cell value, SimulationData *sim) {
+    unsigned int k = sim->halo_depth;
+    cell corner[k * k];
+
+    copy_block(pop, corner, sim->local_augmented_width, k, k, row, col);
+    all_equal(corner, k * k, value);
 }
 
 /**
@@ -69,46 +90,61 @@ void TESTCASE_swap_halos(Arguments *args) {
         MPI_Finalize();
     }
 
-    cell * pop = malloc(sim.local_augmented_height * sim.local_augmented_width * sizeof(cell));
+    // Halos exchanged through windows are swapped between populations allocated by the exchange backend.
+    cell * pop = (sim.swap_buffer->window_base)
+                 ? sim.swap_buffer->window_base
+                 : malloc(sim.local_augmented_height * sim.local_augmented_width * sizeof(cell));
 
-    cell * left = calloc(sim.local_height, sizeof(cell));
-    cell * right = calloc(sim.local_height, sizeof(cell));
-    cell * up = calloc(sim.local_width, sizeof(cell));
-    cell * down = calloc(sim.local_width, sizeof(cell));
+    unsigned int k = sim.halo_depth;
+    unsigned int vertical = k * sim.local_width;
+    unsigned int horizontal = k * sim.local_height;
+
+    cell * left = calloc(horizontal, sizeof(cell));
+    cell * right = calloc(horizontal, sizeof(cell));
+    cell * up = calloc(vertical, sizeof(cell));
+    cell * down = calloc(vertical, sizeof(cell));
 
     generate_reset_and_swap(pop, &sim);
     copy_halos(pop, up, down, left, right, &sim);
 
     if (sim.x_coordinate == 0 && sim.y_coordinate == 1) {
         // Up
-        all_equal(up, sim.local_width, 7);
-        all_equal(down, sim.local_width, 4);
-        all_equal(left, sim.local_height, 0);
-        all_equal(right, sim.local_height, 2);
+        all_equal(up, vertical, 7);
+        all_equal(down, vertical, 4);
+        all_equal(left, horizontal, 0);
+        all_equal(right, horizontal, 2);
     } else if (sim.x_coordinate == 1 && sim.y_coordinate == 0) {
         // Left
-        all_equal(up, sim.local_width, 0);
-        all_equal(down, sim.local_width, 6);
-        all_equal(left, sim.local_height, 0);
-        all_equal(right, sim.local_height, 4);
+        all_equal(up, vertical, 0);
+        all_equal(down, vertical, 6);
+        all_equal(left, horizontal, 0);
+        all_equal(right, horizontal, 4);
     } else if (sim.x_coordinate == 1 && sim.y_coordinate == 1) {
         // Center
-        all_equal(up, sim.local_width, 1);
-        all_equal(down, sim.local_width, 7);
-        all_equal(left, sim.local_height, 3);
-        all_equal(right, sim.local_height, 5);
+        all_equal(up, vertical, 1);
+        all_equal(down, vertical, 7);
+        all_equal(left, horizontal, 3);
+        all_equal(right, horizontal, 5);
+
+        // Corners are only swapped with deep halos.
+        if (k > 1) {
+            check_corner(pop, 0, 0, 0, &sim);
+            check_corner(pop, 0, sim.local_augmented_width - k, 2, &sim);
+            check_corner(pop, sim.local_augmented_height - k, 0, 6, &sim);
+            check_corner(pop, sim.local_augmented_height - k, sim.local_augmented_width - k, 8, &sim);
+        }
     } else if (sim.x_coordinate == 1 && sim.y_coordinate == 2) {
         // Right
-        all_equal(up, sim.local_width, 2);
-        all_equal(down, sim.local_width, 8);
-        all_equal(left, sim.local_height, 4);
-        all_equal(right, sim.local_height, 0);
+        all_equal(up, vertical, 2);
+        all_equal(down, vertical, 8);
+        all_equal(left, horizontal, 4);
+        all_equal(right, horizontal, 0);
     } else if (sim.x_coordinate == 2 && sim.y_coordinate == 1) {
         // Down
-        all_equal(up, sim.local_width, 4);
-        all_equal(down, sim.local_width, 1);
-        all_equal(left, sim.local_height, 6);
-        all_equal(right, sim.local_height, 8);
+        all_equal(up, vertical, 4);
+        all_equal(down, vertical, 1);
+        all_equal(left, horizontal, 6);
+        all_equal(right, horizontal, 8);
     }
 
     free(left);
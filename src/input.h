@@ -0,0 +1,573 @@
+#ifndef MPP_AUTOMATON_INPUT_H
+#define MPP_AUTOMATON_INPUT_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <ctype.h>
+#include <limits.h>
+#include <mpi.h>
+
+#include "automaton.h"
+#include "packed_population.h"
+#include "load_balancer.h"
+#include "io.h"
+
+
+/**
+ * Maximum length of input header, including comments.
+ */
+#define INPUT_HEADER_LEN 4096
+
+/**
+ * Number of bytes read before the chunk of every process, so that run counts of RLE tags at the start of the chunk are
+ * complete.
+ */
+#define INPUT_COUNT_DIGITS 24
+
+/**
+ * Input formats.
+ */
+#define INPUT_ASCII_PBM 0
+#define INPUT_BINARY_PBM 1
+#define INPUT_RLE 2
+
+/**
+ * Fields of input header broadcast by the controller.
+ */
+#define INPUT_VALID 0
+#define INPUT_FORMAT 1
+#define INPUT_WIDTH 2
+#define INPUT_HEIGHT 3
+#define INPUT_OFFSET 4
+#define INPUT_FIELDS 5
+
+/**
+ * Position within an RLE pattern, which also describes the displacement of a chunk of tags. If a chunk holds a line
+ * break, the column is absolute, otherwise it is relative to the start of the chunk.
+ */
+#define RLE_ROW 0
+#define RLE_COL 1
+#define RLE_NEWLINE 2
+#define RLE_FIELDS 3
+
+
+/**
+ * Growable list of global indices of live cells.
+ */
+typedef struct {
+    unsigned long long *cells;
+    size_t count;
+    size_t capacity;
+} CellList;
+
+
+/**
+ * Skips whitespace and comments of a PBM header.
+ *
+ * @param pos   Position within a null-terminated header.
+ * @return      Position of the next token.
+ */
+static inline const char *skip_pbm_space(const char *pos) {
+    while (isspace((unsigned char) *pos) || *pos == '#') {
+        if (*pos == '#') {
+            while (*pos && *pos != '\n') {
+                pos++;
+            }
+        } else {
+            pos++;
+        }
+    }
+
+    return pos;
+}
+
+/**
+ * Parses header of a PBM or RLE pattern. PBM images start with P1 or P4, everything else is parsed as RLE, whose
+ * comment lines are followed by a line giving the size of the pattern. The rule of an RLE pattern is ignored.
+ *
+ * @param buf       Null-terminated beginning of the pattern.
+ * @param fields    Parsed header fields.
+ */
+void parse_input_header(const char *buf, unsigned long long *fields) {
+    const char *pos;
+    int width = 0, height = 0, len = 0;
+
+    fields[INPUT_VALID] = false;
+
+    if (buf[0] == 'P' && (buf[1] == '1' || buf[1] == '4')) {
+        fields[INPUT_FORMAT] = (buf[1] == '1') ? INPUT_ASCII_PBM : INPUT_BINARY_PBM;
+
+        pos = skip_pbm_space(buf + 2);
+
+        if (sscanf(pos, "%d%n", &width, &len) != 1) {
+            return;
+        }
+
+        pos = skip_pbm_space(pos + len);
+
+        if (sscanf(pos, "%d%n", &height, &len) != 1 || !isspace((unsigned char) pos[len])) {
+            return;
+        }
+
+        // Pixels follow a single whitespace character.
+        pos += len + 1;
+    } else {
+        fields[INPUT_FORMAT] = INPUT_RLE;
+        pos = buf;
+
+        while (*pos == '#') {
+            if (!(pos = strchr(pos, '\n'))) {
+                return;
+            }
+
+            pos++;
+        }
+
+        if (sscanf(pos, " x = %d , y = %d%n", &width, &height, &len) != 2 || !(pos = strchr(pos + len, '\n'))) {
+            return;
+        }
+
+        pos++;
+    }
+
+    fields[INPUT_VALID] = width > 0 && height > 0;
+    fields[INPUT_WIDTH] = width;
+    fields[INPUT_HEIGHT] = height;
+    fields[INPUT_OFFSET] = pos - buf;
+}
+
+/**
+ * Appends a cell of the pattern to a list of live cells, unless it is placed outside of the global population.
+ *
+ * @param list  CellList struct.
+ * @param args  Arguments struct.
+ * @param row   Row within the pattern.
+ * @param col   Column within the pattern.
+ */
+static inline void add_input_cell(CellList *list, Arguments *args, long long row, long long col) {
+    row += args->input_offset[0];
+    col += args->input_offset[1];
+
+    if (row < 0 || row >= args->height || col < 0 || col >= args->width) {
+        return;
+    }
+
+    if (list->count == list->capacity) {
+        list->capacity = (list->capacity > 0) ? 2 * list->capacity : 1024;
+        list->cells = realloc(list->cells, list->capacity * sizeof(unsigned long long));
+    }
+
+    list->cells[list->count++] = (unsigned long long) row * args->width + col;
+}
+
+/**
+ * Decodes ASCII PBM pixels, which start at the given pixel index of the pattern. As in the output, live cells are white
+ * pixels.
+ *
+ * @param buf           Pixels.
+ * @param len           Length of the buffer.
+ * @param index         Index of the first pixel within the pattern.
+ * @param fields        Input header fields.
+ * @param args          Arguments struct.
+ * @param list          CellList struct receiving live cells, or NULL if pixels are only counted.
+ * @return              Number of pixels.
+ */
+unsigned long long decode_ascii_pbm(const char *buf, size_t len, unsigned long long index,
+                                    const unsigned long long *fields, Arguments *args, CellList *list) {
+    unsigned long long n_pixels = 0;
+    unsigned long long size = fields[INPUT_WIDTH] * fields[INPUT_HEIGHT];
+
+    for (size_t i = 0; i < len; i++) {
+        if (buf[i] != '0' && buf[i] != '1') {
+            continue;
+        }
+
+        if (list && buf[i] == '0' && index + n_pixels < size) {
+            add_input_cell(list, args, (index + n_pixels) / fields[INPUT_WIDTH], (index + n_pixels) % fields[INPUT_WIDTH]);
+        }
+
+        n_pixels++;
+    }
+
+    return n_pixels;
+}
+
+/**
+ * Decodes RLE tags in buf[begin, end). Every tag is preceded by an optional run count, which may start before begin.
+ * Runs of b are dead cells, $ ends lines, and any other letter gives live cells.
+ *
+ * @param buf       Tags.
+ * @param begin     First position of tags.
+ * @param end       End position of tags.
+ * @param pos       Position within the pattern, updated past the decoded tags.
+ * @param args      Arguments struct.
+ * @param list      CellList struct receiving live cells, or NULL if tags are only measured.
+ */
+void decode_rle(const char *buf, size_t begin, size_t end, unsigned long long *pos, Arguments *args, CellList *list) {
+    for (size_t i = begin; i < end; i++) {
+        char tag = buf[i];
+
+        if (tag != '$' && !isalpha((unsigned char) tag)) {
+            continue;
+        }
+
+        unsigned long long count = 0, scale = 1;
+
+        for (size_t j = i; j > 0 && isdigit((unsigned char) buf[j - 1]); j--, scale *= 10) {
+            count += (buf[j - 1] - '0') * scale;
+        }
+
+        count = (scale > 1) ? count : 1;
+
+        if (tag == '$') {
+            pos[RLE_ROW] += count;
+            pos[RLE_COL] = 0;
+            pos[RLE_NEWLINE] = true;
+        } else {
+            if (list && tag != 'b') {
+                for (unsigned long long k = 0; k < count; k++) {
+                    add_input_cell(list, args, pos[RLE_ROW], pos[RLE_COL] + k);
+                }
+            }
+
+            pos[RLE_COL] += count;
+        }
+    }
+}
+
+/**
+ * Composes displacements of consecutive chunks of RLE tags. Used as a non-commutative reduction, so in is the
+ * displacement of the earlier chunks.
+ *
+ * @param in        Displacement of the earlier chunk.
+ * @param inout     Displacement of the later chunk, set to the composed displacement.
+ * @param len       Number of elements.
+ * @param type      Element type.
+ */
+void compose_rle_displacements(void *in, void *inout, int *len, MPI_Datatype *type) {
+    unsigned long long *a = in, *b = inout;
+
+    for (int i = 0; i < *len; i += RLE_FIELDS, a += RLE_FIELDS, b += RLE_FIELDS) {
+        if (!b[RLE_NEWLINE]) {
+            b[RLE_COL] += a[RLE_COL];
+            b[RLE_NEWLINE] = a[RLE_NEWLINE];
+        }
+
+        b[RLE_ROW] += a[RLE_ROW];
+    }
+}
+
+/**
+ * Reads the pixels of a binary PBM pattern that are placed within the local partition. Every process reads only its own
+ * block of the pattern through a subarray file view.
+ *
+ * @param file          Pattern file opened by all processes.
+ * @param fields        Input header fields.
+ * @param sim           Simulation data.
+ * @param population    Local population of cells, zero initialized.
+ * @param halo          Halo depth.
+ * @return              Local live cell count.
+ */
+unsigned long long read_binary_input(MPI_File file, const unsigned long long *fields, SimulationData *sim,
+                                     cell *population, unsigned int halo) {
+    int partition[4], pattern[4], block[4];
+    int row_bytes = (int) ((fields[INPUT_WIDTH] + PIXELS_PER_BYTE - 1) / PIXELS_PER_BYTE);
+
+    unsigned int rows = 0, cols = 0, first_byte = 0, n_bytes = 0;
+    unsigned long long local_live_cell_count = 0;
+
+    MPI_Datatype file_type = MPI_BYTE;
+
+    get_partition_rect(sim, sim->row_cuts, sim->col_cuts, sim->rank, partition);
+
+    pattern[0] = sim->args->input_offset[0];
+    pattern[1] = pattern[0] + (int) fields[INPUT_HEIGHT];
+    pattern[2] = sim->args->input_offset[1];
+    pattern[3] = pattern[2] + (int) fields[INPUT_WIDTH];
+
+    // Block of the pattern within the partition, relative to the pattern.
+    if (intersect_rects(partition, pattern, block)) {
+        rows = block[1] - block[0];
+        cols = block[3] - block[2];
+        first_byte = (block[2] - pattern[2]) / PIXELS_PER_BYTE;
+        n_bytes = (block[3] - pattern[2] + PIXELS_PER_BYTE - 1) / PIXELS_PER_BYTE - first_byte;
+
+        int sizes[2] = {(int) fields[INPUT_HEIGHT], row_bytes};
+        int subsizes[2] = {(int) rows, (int) n_bytes};
+        int starts[2] = {block[0] - pattern[0], (int) first_byte};
+
+        MPI_Type_create_subarray(2, sizes, subsizes, starts, MPI_ORDER_C, MPI_BYTE, &file_type);
+        MPI_Type_commit(&file_type);
+    }
+
+    unsigned char *buf = malloc((size_t) rows * n_bytes + 1);
+    MPI_Datatype row_type = create_pbm_row_type(n_bytes);
+
+    MPI_File_set_view(file, fields[INPUT_OFFSET], MPI_BYTE, file_type, "native", MPI_INFO_NULL);
+    MPI_File_read_at_all(file, 0, buf, (int) rows, row_type, MPI_STATUS_IGNORE);
+    MPI_Type_free(&row_type);
+
+    unsigned int first_bit = (block[2] - pattern[2]) % PIXELS_PER_BYTE;
+    unsigned int width = sim->local_augmented_width;
+
+#pragma omp parallel for schedule(static) reduction(+:local_live_cell_count)
+    for (unsigned int i = 0; i < rows; i++) {
+        cell *row = &population[(block[0] - partition[0] + i + halo) * width + block[2] - partition[2] + halo];
+
+        for (unsigned int j = 0; j < cols; j++) {
+            unsigned int bit = first_bit + j;
+            unsigned char byte = buf[(size_t) i * n_bytes + bit / PIXELS_PER_BYTE];
+
+            // Black pixels are dead cells.
+            row[j] = !((byte >> (PIXELS_PER_BYTE - 1 - bit % PIXELS_PER_BYTE)) & 1);
+            local_live_cell_count += row[j];
+        }
+    }
+
+    if (file_type != MPI_BYTE) {
+        MPI_Type_free(&file_type);
+    }
+
+    free(buf);
+
+    return local_live_cell_count;
+}
+
+/**
+ * Reads an ASCII PBM or RLE pattern. Positions of pixels and tags depend on everything before them, so the pattern is
+ * split into equal chunks of bytes, one per process, and the position of every chunk is found with a prefix scan of
+ * the chunks before it. Live cells are then sent to the processes that own them.
+ *
+ * @param file          Pattern file opened by all processes.
+ * @param fields        Input header fields.
+ * @param sim           Simulation data.
+ * @param population    Local population of cells, zero initialized.
+ * @param halo          Halo depth.
+ * @return              Local live cell count.
+ */
+unsigned long long read_text_input(MPI_File file, const unsigned long long *fields, SimulationData *sim,
+                                   cell *population, unsigned int halo) {
+    MPI_Offset file_size;
+    MPI_File_get_size(file, &file_size);
+
+    // Chunk of this process, preceded by the bytes that may hold the run count of its first tag.
+    unsigned long long data_size = file_size - fields[INPUT_OFFSET];
+    unsigned long long begin = fields[INPUT_OFFSET] + data_size * sim->rank / sim->n_proc;
+    unsigned long long end = fields[INPUT_OFFSET] + data_size * (sim->rank + 1) / sim->n_proc;
+    unsigned long long prefix = begin - fields[INPUT_OFFSET];
+
+    prefix = (prefix < INPUT_COUNT_DIGITS) ? prefix : INPUT_COUNT_DIGITS;
+
+    size_t len = end - begin + prefix;
+    char *buf = malloc(len + 1);
+
+    // Chunks are read in whole blocks followed by the remaining bytes, so counts don't overflow for large patterns.
+    MPI_Datatype block_type;
+    MPI_Type_contiguous(PBM_BLOCK_SIZE, MPI_CHAR, &block_type);
+    MPI_Type_commit(&block_type);
+
+    MPI_File_read_at_all(file, (MPI_Offset) (begin - prefix), buf, (int) (len / PBM_BLOCK_SIZE), block_type,
+                         MPI_STATUS_IGNORE);
+    MPI_File_read_at_all(file, (MPI_Offset) (begin - prefix + len - len % PBM_BLOCK_SIZE),
+                         buf + len - len % PBM_BLOCK_SIZE, (int) (len % PBM_BLOCK_SIZE), MPI_CHAR, MPI_STATUS_IGNORE);
+    MPI_Type_free(&block_type);
+
+    CellList list = {NULL, 0, 0};
+
+    if (fields[INPUT_FORMAT] == INPUT_ASCII_PBM) {
+        unsigned long long index = 0;
+        unsigned long long n_pixels = decode_ascii_pbm(buf + prefix, len - prefix, 0, fields, sim->args, NULL);
+
+        MPI_Exscan(&n_pixels, &index, 1, MPI_UNSIGNED_LONG_LONG, MPI_SUM, sim->comm);
+
+        if (sim->rank == 0) {
+            index = 0;
+        }
+
+        decode_ascii_pbm(buf + prefix, len - prefix, index, fields, sim->args, &list);
+    } else {
+        MPI_Op op;
+
+        unsigned long long local_stop, stop, displacement[RLE_FIELDS] = {0}, pos[RLE_FIELDS] = {0};
+
+        // Tags end at the first !.
+        char *bang = memchr(buf + prefix, '!', len - prefix);
+        local_stop = bang ? (unsigned long long) (bang - buf) + begin - prefix : ULLONG_MAX;
+
+        MPI_Allreduce(&local_stop, &stop, 1, MPI_UNSIGNED_LONG_LONG, MPI_MIN, sim->comm);
+
+        size_t tags_end = (stop < end) ? ((stop > begin) ? stop - begin + prefix : prefix) : len;
+
+        decode_rle(buf, prefix, tags_end, displacement, sim->args, NULL);
+
+        MPI_Op_create(&compose_rle_displacements, false, &op);
+        MPI_Exscan(displacement, pos, RLE_FIELDS, MPI_UNSIGNED_LONG_LONG, op, sim->comm);
+        MPI_Op_free(&op);
+
+        if (sim->rank == 0) {
+            memset(pos, 0, sizeof(pos));
+        }
+
+        decode_rle(buf, prefix, tags_end, pos, sim->args, &list);
+    }
+
+    free(buf);
+
+    // Owner of every row and column of the global population.
+    int *row_owners = malloc(sim->args->height * sizeof(int));
+    int *col_owners = malloc(sim->args->width * sizeof(int));
+    int *ranks = malloc(sim->rows * sim->cols * sizeof(int));
+
+    for (unsigned int x = 0; x < sim->rows; x++) {
+        for (int i = sim->row_cuts[x]; i < sim->row_cuts[x + 1]; i++) {
+            row_owners[i] = (int) x;
+        }
+
+        for (unsigned int y = 0; y < sim->cols; y++) {
+            int coordinates[2] = {(int) x, (int) y};
+            MPI_Cart_rank(sim->comm, coordinates, &ranks[x * sim->cols + y]);
+        }
+    }
+
+    for (unsigned int y = 0; y < sim->cols; y++) {
+        for (int j = sim->col_cuts[y]; j < sim->col_cuts[y + 1]; j++) {
+            col_owners[j] = (int) y;
+        }
+    }
+
+    // Sort live cells by owner.
+    int *send_counts = calloc(sim->n_proc, sizeof(int));
+    int *recv_counts = malloc(sim->n_proc * sizeof(int));
+    int *send_displs = malloc(sim->n_proc * sizeof(int));
+    int *recv_displs = malloc(sim->n_proc * sizeof(int));
+    int *owners = malloc(list.count * sizeof(int) + 1);
+
+    for (size_t k = 0; k < list.count; k++) {
+        unsigned long long row = list.cells[k] / sim->args->width, col = list.cells[k] % sim->args->width;
+
+        owners[k] = ranks[row_owners[row] * sim->cols + col_owners[col]];
+        send_counts[owners[k]]++;
+    }
+
+    MPI_Alltoall(send_counts, 1, MPI_INT, recv_counts, 1, MPI_INT, sim->comm);
+
+    send_displs[0] = recv_displs[0] = 0;
+
+    for (unsigned int r = 1; r < sim->n_proc; r++) {
+        send_displs[r] = send_displs[r - 1] + send_counts[r - 1];
+        recv_displs[r] = recv_displs[r - 1] + recv_counts[r - 1];
+    }
+
+    int n_recv = recv_displs[sim->n_proc - 1] + recv_counts[sim->n_proc - 1];
+
+    unsigned long long *send_buf = malloc(list.count * sizeof(unsigned long long) + 1);
+    unsigned long long *recv_buf = malloc(n_recv * sizeof(unsigned long long) + 1);
+
+    for (size_t k = 0; k < list.count; k++) {
+        send_buf[send_displs[owners[k]]++] = list.cells[k];
+    }
+
+    for (unsigned int r = 0; r < sim->n_proc; r++) {
+        send_displs[r] -= send_counts[r];
+    }
+
+    MPI_Alltoallv(send_buf, send_counts, send_displs, MPI_UNSIGNED_LONG_LONG, recv_buf, recv_counts, recv_displs,
+                  MPI_UNSIGNED_LONG_LONG, sim->comm);
+
+    unsigned long long local_live_cell_count = 0;
+    unsigned int row_offset = sim->row_cuts[sim->x_coordinate];
+    unsigned int col_offset = sim->col_cuts[sim->y_coordinate];
+
+    for (int k = 0; k < n_recv; k++) {
+        unsigned long long row = recv_buf[k] / sim->args->width, col = recv_buf[k] % sim->args->width;
+        cell *c = &population[(row - row_offset + halo) * sim->local_augmented_width + col - col_offset + halo];
+
+        local_live_cell_count += !*c;
+        *c = 1;
+    }
+
+    free(list.cells);
+    free(row_owners);
+    free(col_owners);
+    free(ranks);
+    free(send_counts);
+    free(recv_counts);
+    free(send_displs);
+    free(recv_displs);
+    free(owners);
+    free(send_buf);
+    free(recv_buf);
+
+    return local_live_cell_count;
+}
+
+/**
+ * Initializes the local population from a pattern in ASCII PBM, binary PBM or RLE format, placed at the input offset
+ * of the global population. Cells outside of the pattern are dead, and cells of the pattern placed outside of the
+ * global population are dropped. The header is parsed by the controller and broadcast, and no process reads the whole
+ * pattern. Halos are left for the first halo swap.
+ *
+ * @param sim           Simulation data.
+ * @param filename      Pattern filename.
+ * @param generation    Local generation of cells, zero initialized.
+ * @return              Local live cell count.
+ */
+unsigned long long read_input(SimulationData *sim, char *filename, void *generation) {
+    MPI_File file;
+
+    unsigned long long fields[INPUT_FIELDS] = {0};
+
+    if (MPI_File_open(sim->comm, filename, MPI_MODE_RDONLY, MPI_INFO_NULL, &file) != MPI_SUCCESS) {
+        if (sim->rank == CONTROLLER_RANK) {
+            fprintf(stderr, "automaton: input %s cannot be opened\n", filename);
+        }
+
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+
+    if (sim->rank == CONTROLLER_RANK) {
+        char buf[INPUT_HEADER_LEN + 1] = {0};
+
+        MPI_File_read_at(file, 0, buf, INPUT_HEADER_LEN, MPI_CHAR, MPI_STATUS_IGNORE);
+        parse_input_header(buf, fields);
+    }
+
+    MPI_Bcast(fields, INPUT_FIELDS, MPI_UNSIGNED_LONG_LONG, CONTROLLER_RANK, sim->comm);
+
+    if (!fields[INPUT_VALID]) {
+        if (sim->rank == CONTROLLER_RANK) {
+            fprintf(stderr, "automaton: %s is not a PBM or RLE pattern\n", filename);
+        }
+
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+
+    unsigned long long local_live_cell_count;
+    cell *population = generation;
+    unsigned int halo = sim->halo_depth;
+
+    if (sim->args->packed) {
+        population = calloc(sim->local_augmented_height * sim->local_augmented_width, sizeof(cell));
+        halo = 1;
+    }
+
+    if (fields[INPUT_FORMAT] == INPUT_BINARY_PBM) {
+        local_live_cell_count = read_binary_input(file, fields, sim, population, halo);
+    } else {
+        local_live_cell_count = read_text_input(file, fields, sim, population, halo);
+    }
+
+    MPI_File_close(&file);
+
+    if (sim->args->packed) {
+        pack_population(population, generation, sim->local_augmented_height, sim->local_augmented_width);
+        free(population);
+    }
+
+    return local_live_cell_count;
+}
+
+
+#endif //MPP_AUTOMATON_INPUT_H
@@ -3,58 +3,347 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdbool.h>
+#include <mpi.h>
 
 #include "population_utils.h"
+#include "automaton.h"
 
 #define PIXELS_PER_LINE 32
+#define PIXELS_PER_BYTE 8
+#define GLOBAL_PBM_FILENAME "cells.pbm"
+#define PBM_BLOCK_SIZE (1 << 22)
 
 
 /**
- * Writes population to PBM file.
+ * Packs a row of cells into bytes of a binary PBM image, 8 pixels per byte with the leftmost pixel in the most
+ * significant bit. Live cells are white, i.e. 0, and padding bits of the last byte are clear.
+ *
+ * @param row   Row of cells.
+ * @param len   Number of cells.
+ * @param buf   Target buffer of (len + 7) / 8 bytes.
+ */
+void pack_pbm_row(cell *row, unsigned int len, unsigned char *buf) {
+    for (unsigned int b = 0; b < (len + PIXELS_PER_BYTE - 1) / PIXELS_PER_BYTE; b++) {
+        unsigned char byte = 0;
+
+        for (unsigned int k = 0; k < PIXELS_PER_BYTE && b * PIXELS_PER_BYTE + k < len; k++) {
+            byte |= (row[b * PIXELS_PER_BYTE + k] != 1) << (PIXELS_PER_BYTE - 1 - k);
+        }
+
+        buf[b] = byte;
+    }
+}
+
+/**
+ * Formats a row of cells as pixels of an ASCII PBM image. Every pixel takes two characters, a digit followed by a
+ * separator, and lines are broken after every PIXELS_PER_LINE pixels of the image and after its last pixel. Live cells
+ * are white, i.e. 0.
+ *
+ * @param row   Row of cells.
+ * @param len   Number of cells.
+ * @param first Index of the first pixel of the row within the image.
+ * @param total Number of pixels in the image.
+ * @param buf   Target buffer of 2 * len characters.
+ */
+void format_pbm_row(cell *row, unsigned int len, unsigned long long first, unsigned long long total, char *buf) {
+    for (unsigned int j = 0; j < len; j++) {
+        unsigned long long pixel = first + j;
+
+        buf[2 * j] = row[j] == 1 ? '0' : '1';
+        buf[2 * j + 1] = ((pixel + 1) % PIXELS_PER_LINE == 0 || pixel + 1 == total) ? '\n' : ' ';
+    }
+}
+
+/**
+ * Writes population to PBM file. Pixels are formatted into a pre-sized buffer a block of rows at a time, and each block
+ * is written with a single fwrite.
  *
  * @param filename      Filename.
  * @param population    Population of cells.
  * @param height        Height of the population.
  * @param width         Width of the population.
+ * @param halo          Halo depth.
+ * @param binary        If true, image is written as binary PBM (P4), otherwise as ASCII PBM (P1).
  */
-void to_pbm(char *filename, cell *population, unsigned int height, unsigned int width) {
+void to_pbm(char *filename, cell *population, unsigned int height, unsigned int width, unsigned int halo,
+            bool binary) {
     FILE *file;
 
-    int cursor, value;
+    unsigned int rows = height - 2 * halo;
+    unsigned int cols = width - 2 * halo;
+    size_t row_size = binary ? (cols + PIXELS_PER_BYTE - 1) / PIXELS_PER_BYTE : 2 * (size_t) cols;
+    unsigned int block_rows = row_size < PBM_BLOCK_SIZE ? PBM_BLOCK_SIZE / row_size : 1;
 
-    file = fopen(filename, "w");
+    file = fopen(filename, "wb");
 
-    fprintf(file, "P1\n");
-    fprintf(file, "%d %d\n", width - 2, height - 2);
+    fprintf(file, "%s\n", binary ? "P4" : "P1");
+    fprintf(file, "%d %d\n", cols, rows);
 
-    cursor = 0;
+    char *buf = malloc(block_rows * row_size);
 
-    for (unsigned int i = 1; i < height - 1; i++) {
-        for (unsigned int j = 1; j < width - 1; j++) {
-            cursor++;
+    for (unsigned int first = 0; first < rows; first += block_rows) {
+        unsigned int n = rows - first < block_rows ? rows - first : block_rows;
 
-            value = 1;
+#pragma omp parallel for schedule(static)
+        for (unsigned int i = 0; i < n; i++) {
+            cell *row = &population[(first + i + halo) * width + halo];
 
-            if (population[i * width + j] == 1) {
-                value = 0;
+            if (binary) {
+                pack_pbm_row(row, cols, (unsigned char *) &buf[i * row_size]);
+            } else {
+                format_pbm_row(row, cols, (unsigned long long) (first + i) * cols, (unsigned long long) rows * cols,
+                               &buf[i * row_size]);
             }
+        }
 
-            if (cursor == 1) {
-                fprintf(file, "%1d", value);
-            } else if (cursor < PIXELS_PER_LINE) {
-                fprintf(file, " %1d", value);
-            } else {
-                fprintf(file, " %1d\n", value);
-                cursor = 0;
+        fwrite(buf, 1, n * row_size, file);
+    }
+
+    free(buf);
+    fclose(file);
+}
+
+/**
+ * Computes size of the pixels of a global binary PBM image.
+ *
+ * @param sim   Simulation data.
+ * @return      Size in bytes.
+ */
+static inline MPI_Offset get_pbm_image_size(SimulationData *sim) {
+    return (MPI_Offset) sim->args->height * ((sim->args->width + PIXELS_PER_BYTE - 1) / PIXELS_PER_BYTE);
+}
+
+/**
+ * Creates file type that selects a block of bytes in every local row of a global binary PBM image.
+ *
+ * @param sim           Simulation data.
+ * @param first_byte    First byte of the block within an image row.
+ * @param n_bytes       Number of bytes in the block, at least 1.
+ * @return              Committed file type.
+ */
+MPI_Datatype create_pbm_file_type(SimulationData *sim, unsigned int first_byte, unsigned int n_bytes) {
+    MPI_Datatype file_type;
+
+    int sizes[2] = {sim->args->height, (int) ((sim->args->width + PIXELS_PER_BYTE - 1) / PIXELS_PER_BYTE)};
+    int subsizes[2] = {(int) sim->local_height, (int) n_bytes};
+    int starts[2] = {sim->row_cuts[sim->x_coordinate], (int) first_byte};
+
+    MPI_Type_create_subarray(2, sizes, subsizes, starts, MPI_ORDER_C, MPI_BYTE, &file_type);
+    MPI_Type_commit(&file_type);
+
+    return file_type;
+}
+
+/**
+ * Creates memory type of a row of bytes in a staging buffer, so that reads and writes count rows rather than bytes and
+ * their counts don't overflow for large partitions.
+ *
+ * @param n_bytes   Number of bytes in a row.
+ * @return          Committed memory type.
+ */
+MPI_Datatype create_pbm_row_type(unsigned int n_bytes) {
+    MPI_Datatype row_type;
+
+    MPI_Type_contiguous((int) n_bytes, MPI_BYTE, &row_type);
+    MPI_Type_commit(&row_type);
+
+    return row_type;
+}
+
+/**
+ * Finds bytes of every row of a global binary PBM image written by this process, i.e. bytes whose first pixel falls
+ * within its partition.
+ *
+ * @param sim           Simulation data.
+ * @param first_byte    First byte within an image row.
+ * @param n_bytes       Number of bytes, possibly 0 if partition is narrower than a byte.
+ */
+static inline void get_owned_pbm_bytes(SimulationData *sim, unsigned int *first_byte, unsigned int *n_bytes) {
+    unsigned int col_offset = sim->col_cuts[sim->y_coordinate];
+    unsigned int col_end = col_offset + sim->local_width;
+
+    *first_byte = (col_offset + PIXELS_PER_BYTE - 1) / PIXELS_PER_BYTE;
+    *n_bytes = (col_end + PIXELS_PER_BYTE - 1) / PIXELS_PER_BYTE - *first_byte;
+}
+
+/**
+ * Packs pixels of global population written by this process. Every byte of the image is written by the process that
+ * holds its first pixel, so partitions need not be aligned to bytes. Bytes that extend into the partitions to the right
+ * are completed with their leading cells, which are gathered along the row of processes.
+ *
+ * @param sim           Simulation data.
+ * @param population    Local population of cells.
+ * @param halo          Halo depth.
+ * @param buf           Target buffer of local height times the number of owned bytes.
+ * @return              File type that places the buffer within the image, or MPI_BYTE if no bytes are owned.
+ */
+MPI_Datatype pack_global_pbm_pixels(SimulationData *sim, cell *population, unsigned int halo, unsigned char *buf) {
+    MPI_Comm row_comm;
+    MPI_Datatype file_type = MPI_BYTE;
+
+    unsigned int rows = sim->local_height;
+    unsigned int cols = sim->local_width;
+    unsigned int width = sim->local_augmented_width;
+    unsigned int global_width = sim->args->width;
+    unsigned int col_offset = sim->col_cuts[sim->y_coordinate];
+    unsigned int col_end = col_offset + cols;
+    unsigned int first_byte, n_bytes;
+
+    get_owned_pbm_bytes(sim, &first_byte, &n_bytes);
+
+    // Gather leading cells of every partition in the row of processes as bit masks.
+    int remain_dims[2] = {false, true};
+    MPI_Cart_sub(sim->comm, remain_dims, &row_comm);
+
+    unsigned char *local_leading = malloc(rows);
+    unsigned char *leading = malloc(rows * sim->cols);
+
+    for (unsigned int i = 0; i < rows; i++) {
+        local_leading[i] = 0;
+
+        for (unsigned int k = 0; k < PIXELS_PER_BYTE && k < cols; k++) {
+            local_leading[i] |= (population[(i + halo) * width + halo + k] == 1) << k;
+        }
+    }
+
+    MPI_Allgather(local_leading, rows, MPI_UNSIGNED_CHAR, leading, rows, MPI_UNSIGNED_CHAR, row_comm);
+
+    // Pack rows of owned bytes, completing the last byte with cells of partitions to the right.
+    unsigned int first_col = first_byte * PIXELS_PER_BYTE - col_offset;
+    unsigned int end_col = (first_byte + n_bytes) * PIXELS_PER_BYTE;
+    unsigned int spill = (end_col < global_width ? end_col : global_width) - col_end;
+
+    if (n_bytes > 0) {
+#pragma omp parallel for schedule(static)
+        for (unsigned int i = 0; i < rows; i++) {
+            unsigned char *bytes = &buf[(size_t) i * n_bytes];
+
+            pack_pbm_row(&population[(i + halo) * width + halo + first_col], cols - first_col, bytes);
+
+            for (unsigned int c = col_end, q = sim->y_coordinate + 1; c < col_end + spill; c++) {
+                while (c >= (unsigned int) sim->col_cuts[q + 1]) {
+                    q++;
+                }
+
+                if (!((leading[q * rows + i] >> (c - sim->col_cuts[q])) & 1)) {
+                    bytes[n_bytes - 1] |= 1 << (PIXELS_PER_BYTE - 1 - (c - col_offset - first_col) % PIXELS_PER_BYTE);
+                }
             }
         }
+
+        file_type = create_pbm_file_type(sim, first_byte, n_bytes);
     }
 
-    if (cursor != 0) {
-        fprintf(file, "\n");
+    MPI_Comm_free(&row_comm);
+
+    free(local_leading);
+    free(leading);
+
+    return file_type;
+}
+
+/**
+ * Writes pixels of global population to a binary PBM image with collective MPI-IO. The pixels of each process are
+ * placed by a subarray file view.
+ *
+ * @param file          File opened by all processes.
+ * @param offset        Offset of the pixels within the file, i.e. past the image header.
+ * @param sim           Simulation data.
+ * @param population    Local population of cells.
+ * @param halo          Halo depth.
+ */
+void write_global_pbm_pixels(MPI_File file, MPI_Offset offset, SimulationData *sim, cell *population,
+                             unsigned int halo) {
+    unsigned int first_byte, n_bytes;
+
+    get_owned_pbm_bytes(sim, &first_byte, &n_bytes);
+
+    unsigned char *buf = malloc((size_t) sim->local_height * n_bytes);
+    MPI_Datatype file_type = pack_global_pbm_pixels(sim, population, halo, buf);
+    MPI_Datatype row_type = create_pbm_row_type(n_bytes);
+
+    MPI_File_set_view(file, offset, MPI_BYTE, file_type, "native", MPI_INFO_NULL);
+    MPI_File_write_at_all(file, 0, buf, (int) sim->local_height, row_type, MPI_STATUS_IGNORE);
+
+    if (file_type != MPI_BYTE) {
+        MPI_Type_free(&file_type);
     }
 
-    fclose(file);
+    MPI_Type_free(&row_type);
+
+    free(buf);
+}
+
+/**
+ * Reads pixels of global population from a binary PBM image with collective MPI-IO. Every process reads the bytes that
+ * cover its partition through a subarray file view, so bytes shared by neighbouring partitions are read by both.
+ *
+ * @param file          File opened by all processes.
+ * @param offset        Offset of the pixels within the file, i.e. past the image header.
+ * @param sim           Simulation data.
+ * @param population    Local population of cells, whose interior is overwritten.
+ * @param halo          Halo depth.
+ */
+void read_global_pbm_pixels(MPI_File file, MPI_Offset offset, SimulationData *sim, cell *population,
+                            unsigned int halo) {
+    unsigned int rows = sim->local_height;
+    unsigned int cols = sim->local_width;
+    unsigned int width = sim->local_augmented_width;
+    unsigned int col_offset = sim->col_cuts[sim->y_coordinate];
+
+    // Bytes that hold at least one pixel of this partition.
+    unsigned int first_byte = col_offset / PIXELS_PER_BYTE;
+    unsigned int n_bytes = (col_offset + cols + PIXELS_PER_BYTE - 1) / PIXELS_PER_BYTE - first_byte;
+
+    unsigned char *buf = malloc((size_t) rows * n_bytes);
+    MPI_Datatype file_type = create_pbm_file_type(sim, first_byte, n_bytes);
+    MPI_Datatype row_type = create_pbm_row_type(n_bytes);
+
+    MPI_File_set_view(file, offset, MPI_BYTE, file_type, "native", MPI_INFO_NULL);
+    MPI_File_read_at_all(file, 0, buf, (int) rows, row_type, MPI_STATUS_IGNORE);
+
+#pragma omp parallel for schedule(static)
+    for (unsigned int i = 0; i < rows; i++) {
+        for (unsigned int j = 0; j < cols; j++) {
+            unsigned int bit = col_offset % PIXELS_PER_BYTE + j;
+            unsigned char byte = buf[(size_t) i * n_bytes + bit / PIXELS_PER_BYTE];
+
+            // Black pixels are dead cells.
+            population[(i + halo) * width + halo + j] = !((byte >> (PIXELS_PER_BYTE - 1 - bit % PIXELS_PER_BYTE)) & 1);
+        }
+    }
+
+    MPI_Type_free(&file_type);
+    MPI_Type_free(&row_type);
+    free(buf);
+}
+
+/**
+ * Writes global population to a single binary PBM (P4) file with collective MPI-IO. The header is written by the
+ * controller, followed by the pixels of all processes.
+ *
+ * @param filename      Filename.
+ * @param sim           Simulation data.
+ * @param population    Local population of cells.
+ * @param halo          Halo depth.
+ */
+void to_global_pbm(char *filename, SimulationData *sim, cell *population, unsigned int halo) {
+    MPI_File file;
+
+    char header[64];
+    int header_len = snprintf(header, sizeof(header), "P4\n%d %d\n", sim->args->width, sim->args->height);
+
+    MPI_File_open(sim->comm, filename, MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL, &file);
+    MPI_File_set_size(file, header_len + get_pbm_image_size(sim));
+
+    if (sim->rank == CONTROLLER_RANK) {
+        MPI_File_write_at(file, 0, header, header_len, MPI_CHAR, MPI_STATUS_IGNORE);
+    }
+
+    write_global_pbm_pixels(file, header_len, sim, population, halo);
+
+    MPI_File_close(&file);
 }
 
 
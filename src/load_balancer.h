@@ -0,0 +1,331 @@
+#ifndef MPP_AUTOMATON_LOAD_BALANCER_H
+#define MPP_AUTOMATON_LOAD_BALANCER_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+#include <mpi.h>
+
+#include "automaton.h"
+
+
+/**
+ * Partitions are only rebalanced if the busiest process computes at least this many times longer than the average.
+ */
+#define REBALANCE_THRESHOLD 1.1
+
+/**
+ * Tag of messages migrating a generation of cells, offset by the generation. Halo messages are tagged with directions.
+ */
+#define MIGRATION_TAG 4
+
+
+/**
+ * Moves cut positions of rows or columns of the process grid, so that each partition gets an equal share of the load.
+ * Load of each partition is assumed to be spread uniformly over its rows or columns. Partitions are kept at least
+ * min_len long.
+ *
+ * @param loads     Load of each partition.
+ * @param cuts      Current cut positions, n + 1 elements.
+ * @param n         Number of partitions.
+ * @param min_len   Minimum length of a partition.
+ * @param new_cuts  Balanced cut positions, n + 1 elements.
+ */
+void balance_cuts(const double *loads, const int *cuts, int n, int min_len, int *new_cuts) {
+    double total = 0, cumulative = 0, target, fraction;
+    int pos = 0;
+
+    for (int i = 0; i < n; i++) {
+        total += loads[i];
+    }
+
+    memcpy(new_cuts, cuts, (n + 1) * sizeof(int));
+
+    if (total <= 0) {
+        return;
+    }
+
+    for (int k = 1; k < n; k++) {
+        target = total * k / n;
+
+        // Find partition in which cumulative load crosses target.
+        while (pos < n - 1 && cumulative + loads[pos] < target) {
+            cumulative += loads[pos];
+            pos++;
+        }
+
+        fraction = (loads[pos] > 0) ? (target - cumulative) / loads[pos] : 0;
+        fraction = (fraction < 1) ? fraction : 1;
+
+        new_cuts[k] = cuts[pos] + (int) lround(fraction * (cuts[pos + 1] - cuts[pos]));
+    }
+
+    // Keep partitions at least min_len long.
+    for (int k = 1; k < n; k++) {
+        if (new_cuts[k] < new_cuts[k - 1] + min_len) {
+            new_cuts[k] = new_cuts[k - 1] + min_len;
+        }
+    }
+
+    for (int k = n - 1; k > 0; k--) {
+        if (new_cuts[k] > new_cuts[k + 1] - min_len) {
+            new_cuts[k] = new_cuts[k + 1] - min_len;
+        }
+    }
+}
+
+
+/**
+ * Computes cut positions of the process grid that balance measured loads of processes. Loads of processes are summed
+ * over rows and columns of the process grid, which are balanced independently, so that the grid stays cartesian. Cuts
+ * are left in place if the load is already balanced.
+ *
+ * @param sim       SimulationData struct.
+ * @param loads     Load of each process.
+ * @param cuts      New row cut positions followed by new column cut positions.
+ * @param step      Step number.
+ */
+void plan_cuts(SimulationData *sim, const double *loads, int *cuts, unsigned int step) {
+    double *row_loads = calloc(sim->rows, sizeof(double));
+    double *col_loads = calloc(sim->cols, sizeof(double));
+    double max_load = 0, total_load = 0;
+    int coordinates[2];
+
+    for (unsigned int rank = 0; rank < sim->n_proc; rank++) {
+        MPI_Cart_coords(sim->comm, rank, 2, coordinates);
+
+        row_loads[coordinates[0]] += loads[rank];
+        col_loads[coordinates[1]] += loads[rank];
+
+        max_load = (loads[rank] > max_load) ? loads[rank] : max_load;
+        total_load += loads[rank];
+    }
+
+    double imbalance = (total_load > 0) ? max_load * sim->n_proc / total_load : 1;
+
+    if (imbalance < REBALANCE_THRESHOLD) {
+        memcpy(cuts, sim->row_cuts, (sim->rows + 1) * sizeof(int));
+        memcpy(cuts + sim->rows + 1, sim->col_cuts, (sim->cols + 1) * sizeof(int));
+    } else {
+        balance_cuts(row_loads, sim->row_cuts, sim->rows, sim->halo_depth, cuts);
+        balance_cuts(col_loads, sim->col_cuts, sim->cols, sim->halo_depth, cuts + sim->rows + 1);
+
+        printf("automaton: step = %u, load imbalance = %.2f, rebalancing partitions\n", step, imbalance);
+    }
+
+    free(row_loads);
+    free(col_loads);
+}
+
+
+/**
+ * Computes global rectangle [top, bottom) x [left, right) covered by the population of a process.
+ *
+ * @param sim       SimulationData struct.
+ * @param row_cuts  Row cut positions.
+ * @param col_cuts  Column cut positions.
+ * @param rank      Rank of the process.
+ * @param rect      Top, bottom, left and right edge of the rectangle.
+ */
+static inline void get_partition_rect(SimulationData *sim, const int *row_cuts, const int *col_cuts, int rank,
+                                      int *rect) {
+    int coordinates[2];
+
+    MPI_Cart_coords(sim->comm, rank, 2, coordinates);
+
+    rect[0] = row_cuts[coordinates[0]];
+    rect[1] = row_cuts[coordinates[0] + 1];
+    rect[2] = col_cuts[coordinates[1]];
+    rect[3] = col_cuts[coordinates[1] + 1];
+}
+
+
+/**
+ * Intersects two rectangles.
+ *
+ * @param a     First rectangle.
+ * @param b     Second rectangle.
+ * @param out   Intersection.
+ * @return      True if intersection is not empty, otherwise false.
+ */
+static inline bool intersect_rects(const int *a, const int *b, int *out) {
+    out[0] = (a[0] > b[0]) ? a[0] : b[0];
+    out[1] = (a[1] < b[1]) ? a[1] : b[1];
+    out[2] = (a[2] > b[2]) ? a[2] : b[2];
+    out[3] = (a[3] < b[3]) ? a[3] : b[3];
+
+    return out[0] < out[1] && out[2] < out[3];
+}
+
+
+/**
+ * Creates datatype that selects a block of cells in-place from an augmented population.
+ *
+ * @param block     Global rectangle of the block.
+ * @param rect      Global rectangle of the population.
+ * @param halo      Halo depth.
+ * @param type      Committed datatype.
+ */
+static inline void create_block_type(const int *block, const int *rect, unsigned int halo, MPI_Datatype *type) {
+    int sizes[2] = {rect[1] - rect[0] + 2 * (int) halo, rect[3] - rect[2] + 2 * (int) halo};
+    int subsizes[2] = {block[1] - block[0], block[3] - block[2]};
+    int starts[2] = {block[0] - rect[0] + (int) halo, block[2] - rect[2] + (int) halo};
+
+    MPI_Type_create_subarray(2, sizes, subsizes, starts, MPI_ORDER_C, MPI_CELL, type);
+    MPI_Type_commit(type);
+}
+
+
+/**
+ * Migrates both generations of cells from old partitions to new partitions. Every process sends the part of its old
+ * population covered by the new population of another process, which only involves neighbours unless cuts move by more
+ * than a partition.
+ *
+ * @param sim           SimulationData struct.
+ * @param old_pops      Both generations in old partitions.
+ * @param new_pops      Both generations in new partitions.
+ * @param row_cuts      New row cut positions.
+ * @param col_cuts      New column cut positions.
+ */
+void migrate_populations(SimulationData *sim, cell **old_pops, cell **new_pops, const int *row_cuts,
+                         const int *col_cuts) {
+    MPI_Request *requests = malloc(4 * sim->n_proc * sizeof(MPI_Request));
+    MPI_Datatype *types = malloc(4 * sim->n_proc * sizeof(MPI_Datatype));
+    int old_rect[4], new_rect[4], other_old_rect[4], other_new_rect[4], block[4];
+    int n_requests = 0;
+
+    get_partition_rect(sim, sim->row_cuts, sim->col_cuts, sim->rank, old_rect);
+    get_partition_rect(sim, row_cuts, col_cuts, sim->rank, new_rect);
+
+    for (unsigned int rank = 0; rank < sim->n_proc; rank++) {
+        get_partition_rect(sim, sim->row_cuts, sim->col_cuts, rank, other_old_rect);
+        get_partition_rect(sim, row_cuts, col_cuts, rank, other_new_rect);
+
+        for (int g = 0; g < 2; g++) {
+            if (intersect_rects(new_rect, other_old_rect, block)) {
+                create_block_type(block, new_rect, sim->halo_depth, &types[n_requests]);
+                MPI_Irecv(new_pops[g], 1, types[n_requests], rank, MIGRATION_TAG + g, sim->comm,
+                          &requests[n_requests]);
+                n_requests++;
+            }
+
+            if (intersect_rects(old_rect, other_new_rect, block)) {
+                create_block_type(block, old_rect, sim->halo_depth, &types[n_requests]);
+                MPI_Isend(old_pops[g], 1, types[n_requests], rank, MIGRATION_TAG + g, sim->comm,
+                          &requests[n_requests]);
+                n_requests++;
+            }
+        }
+    }
+
+    MPI_Waitall(n_requests, requests, MPI_STATUSES_IGNORE);
+
+    for (int i = 0; i < n_requests; i++) {
+        MPI_Type_free(&types[i]);
+    }
+
+    free(requests);
+    free(types);
+}
+
+
+/**
+ * Rebalances partitions between processes using compute time measured since the last rebalancing, excluding halo
+ * swaps. The controller decides new cut positions, and if they moved, both generations of cells migrate to the new
+ * partitions and swap buffers and tiles are rebuilt. Must be called right before halos are swapped.
+ *
+ * @param sim               SimulationData struct.
+ * @param fst_generation    Current generation of cells, replaced if partitions change.
+ * @param snd_generation    Previous generation of cells, replaced if partitions change.
+ * @param step              Step number.
+ * @return                  True if partitions changed, otherwise false.
+ */
+bool rebalance_population(SimulationData *sim, void **fst_generation, void **snd_generation, unsigned int step) {
+    unsigned int n_cuts = sim->rows + sim->cols + 2;
+    double load = sim->step_time - sim->exchange_time, *loads = NULL;
+    int *cuts = malloc(n_cuts * sizeof(int));
+
+    if (sim->rank == CONTROLLER_RANK) {
+        loads = malloc(sim->n_proc * sizeof(double));
+    }
+
+    MPI_Gather(&load, 1, MPI_DOUBLE, loads, 1, MPI_DOUBLE, CONTROLLER_RANK, sim->comm);
+
+    if (sim->rank == CONTROLLER_RANK) {
+        plan_cuts(sim, loads, cuts, step);
+        free(loads);
+    }
+
+    MPI_Bcast(cuts, n_cuts, MPI_INT, CONTROLLER_RANK, sim->comm);
+
+    sim->step_time = 0;
+    sim->exchange_time = 0;
+
+    int *row_cuts = cuts, *col_cuts = cuts + sim->rows + 1;
+
+    if (memcmp(row_cuts, sim->row_cuts, (sim->rows + 1) * sizeof(int)) == 0 &&
+        memcmp(col_cuts, sim->col_cuts, (sim->cols + 1) * sizeof(int)) == 0) {
+        free(cuts);
+        return false;
+    }
+
+    // Allocate and migrate populations.
+    unsigned int x = sim->x_coordinate, y = sim->y_coordinate;
+    unsigned int local_height = row_cuts[x + 1] - row_cuts[x];
+    unsigned int local_width = col_cuts[y + 1] - col_cuts[y];
+    unsigned int local_augmented_height = local_height + 2 * sim->halo_depth;
+    unsigned int local_augmented_width = local_width + 2 * sim->halo_depth;
+    size_t n_cells = local_augmented_height * local_augmented_width;
+
+    cell *old_pops[2] = {*fst_generation, *snd_generation};
+    cell *new_pops[2] = {malloc(n_cells * sizeof(cell)), malloc(n_cells * sizeof(cell))};
+
+    first_touch_population(new_pops[0], local_augmented_height, local_augmented_width * sizeof(cell));
+    first_touch_population(new_pops[1], local_augmented_height, local_augmented_width * sizeof(cell));
+
+    migrate_populations(sim, old_pops, new_pops, row_cuts, col_cuts);
+
+    free(old_pops[0]);
+    free(old_pops[1]);
+
+    *fst_generation = new_pops[0];
+    *snd_generation = new_pops[1];
+
+    memcpy(sim->row_cuts, row_cuts, (sim->rows + 1) * sizeof(int));
+    memcpy(sim->col_cuts, col_cuts, (sim->cols + 1) * sizeof(int));
+    free(cuts);
+
+    sim->local_height = local_height;
+    sim->local_width = local_width;
+    sim->local_augmented_height = local_augmented_height;
+    sim->local_augmented_width = local_augmented_width;
+
+    // Rebuild swap buffer and tiles for the new population shape.
+    int shape[2] = {sim->rows, sim->cols};
+    int neighbours[4];
+
+    neighbours[UP] = sim->upper_neighbour;
+    neighbours[RIGHT] = sim->right_neighbour;
+    neighbours[DOWN] = sim->lower_neighbour;
+    neighbours[LEFT] = sim->left_neighbour;
+
+    free_swap_buffer(sim->swap_buffer);
+    free(sim->swap_buffer);
+
+    sim->swap_buffer = init_exchange_swap_buffer(sim->comm, shape, neighbours, sim->args, sim->exchange, local_height,
+                                                 local_width);
+
+    if (sim->tile_grid) {
+        free_tile_grid(sim->tile_grid);
+
+        sim->tile_grid = init_tile_grid(local_augmented_height, local_augmented_width, sim->args->tile_size,
+                                        sim->halo_depth, sim->args->activity);
+    }
+
+    return true;
+}
+
+
+#endif //MPP_AUTOMATON_LOAD_BALANCER_H
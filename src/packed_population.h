@@ -0,0 +1,545 @@
+#ifndef MPP_AUTOMATON_PACKED_POPULATION_H
+#define MPP_AUTOMATON_PACKED_POPULATION_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "population_utils.h"
+#include "rules.h"
+
+
+/**
+ * Packed cell word definition. Cell (i, j) of an augmented population is stored in bit j % CELLS_PER_WORD of word
+ * i * row_words + j / CELLS_PER_WORD. Padding bits past the last column are kept at zero.
+ */
+#define MPI_CELL_WORD MPI_UINT64_T
+#define CELLS_PER_WORD 64
+typedef uint64_t cell_word;
+
+
+/**
+ * Computes the number of words needed to store a single row of cells.
+ *
+ * @param width Row width in cells.
+ * @return      Number of words per row.
+ */
+static inline unsigned int get_row_words(unsigned int width) {
+    return (width + CELLS_PER_WORD - 1) / CELLS_PER_WORD;
+}
+
+/**
+ * Reads a single cell from packed population.
+ *
+ * @param mat   Packed population of cells.
+ * @param i     Row index.
+ * @param j     Column index.
+ * @param words Number of words per row.
+ * @return      Cell value.
+ */
+static inline cell get_packed_cell(cell_word *mat, unsigned int i, unsigned int j, unsigned int words) {
+    return (mat[i * words + j / CELLS_PER_WORD] >> (j % CELLS_PER_WORD)) & 1;
+}
+
+/**
+ * Writes a single cell into packed population.
+ *
+ * @param mat   Packed population of cells.
+ * @param i     Row index.
+ * @param j     Column index.
+ * @param words Number of words per row.
+ * @param value Cell value.
+ */
+static inline void set_packed_cell(cell_word *mat, unsigned int i, unsigned int j, unsigned int words, cell value) {
+    cell_word bit = (cell_word) 1 << (j % CELLS_PER_WORD);
+
+    if (value) {
+        mat[i * words + j / CELLS_PER_WORD] |= bit;
+    } else {
+        mat[i * words + j / CELLS_PER_WORD] &= ~bit;
+    }
+}
+
+/**
+ * Computes the mask of interior cells stored in a given word of a row, i.e. all cells except the left and right halo
+ * and padding.
+ *
+ * @param k     Word index within the row.
+ * @param words Number of words per row.
+ * @param width Augmented row width in cells.
+ * @return      Interior mask.
+ */
+static inline cell_word get_interior_mask(unsigned int k, unsigned int words, unsigned int width) {
+    cell_word mask = ~(cell_word) 0;
+
+    if (k == 0) {
+        mask &= ~(cell_word) 1;
+    }
+
+    if (k + 1 == words) {
+        unsigned int halo = (width - 1) % CELLS_PER_WORD;
+
+        mask &= (halo == 0) ? 0 : ~(cell_word) 0 >> (CELLS_PER_WORD - halo);
+    }
+
+    return mask;
+}
+
+/**
+ * Packs augmented population of cells.
+ *
+ * @param mat       Augmented population of cells.
+ * @param buf       Packed buffer of height * get_row_words(width) words.
+ * @param height    Height of the population.
+ * @param width     Width of the population.
+ */
+void pack_population(cell *mat, cell_word *buf, unsigned int height, unsigned int width) {
+    unsigned int words = get_row_words(width);
+
+    for (unsigned int i = 0; i < height * words; i++) {
+        buf[i] = 0;
+    }
+
+    for (unsigned int i = 0; i < height; i++) {
+        for (unsigned int j = 0; j < width; j++) {
+            buf[i * words + j / CELLS_PER_WORD] |= (cell_word) (mat[i * width + j] & 1) << (j % CELLS_PER_WORD);
+        }
+    }
+}
+
+/**
+ * Unpacks augmented population of cells.
+ *
+ * @param mat       Packed population of cells.
+ * @param buf       Buffer of height * width cells.
+ * @param height    Height of the population.
+ * @param width     Width of the population.
+ */
+void unpack_population(cell_word *mat, cell *buf, unsigned int height, unsigned int width) {
+    unsigned int words = get_row_words(width);
+
+    for (unsigned int i = 0; i < height; i++) {
+        for (unsigned int j = 0; j < width; j++) {
+            buf[i * width + j] = get_packed_cell(mat, i, j, words);
+        }
+    }
+}
+
+/**
+ * Extracts single packed row into a buffer of cells using offset.
+ *
+ * @param mat       Packed population of cells.
+ * @param row       Target buffer.
+ * @param width     Row width in cells.
+ * @param len       Length of the row to be extracted.
+ * @param pos       Row number.
+ * @param offset    Offset to apply.
+ */
+void copy_packed_row(cell_word *mat, cell *row, unsigned int width, unsigned int len, unsigned int pos,
+                     unsigned int offset) {
+    unsigned int words = get_row_words(width);
+
+    for (unsigned int i = 0; i < len; i++) {
+        row[i] = get_packed_cell(mat, pos, i + offset, words);
+    }
+}
+
+/**
+ * Extracts single packed column into a buffer of cells using offset.
+ *
+ * @param mat       Packed population of cells.
+ * @param col       Target buffer.
+ * @param width     Row width in cells.
+ * @param len       Length of the column to be extracted.
+ * @param pos       Column number.
+ * @param offset    Offset to apply.
+ */
+void copy_packed_column(cell_word *mat, cell *col, unsigned int width, unsigned int len, unsigned int pos,
+                        unsigned int offset) {
+    unsigned int words = get_row_words(width);
+
+    for (unsigned int i = 0; i < len; i++) {
+        col[i] = get_packed_cell(mat, i + offset, pos, words);
+    }
+}
+
+/**
+ * Inserts buffer of cells into packed population as a row using offset.
+ *
+ * @param mat       Packed population of cells.
+ * @param row       Source buffer.
+ * @param width     Row width in cells.
+ * @param len       Length of the source buffer.
+ * @param pos       Row number.
+ * @param offset    Offset to apply.
+ */
+void insert_packed_row(cell_word *mat, cell *row, unsigned int width, unsigned int len, unsigned int pos,
+                       unsigned int offset) {
+    unsigned int words = get_row_words(width);
+
+    for (unsigned int i = 0; i < len; i++) {
+        set_packed_cell(mat, pos, i + offset, words, row[i]);
+    }
+}
+
+/**
+ * Inserts buffer of cells into packed population as a column using offset.
+ *
+ * @param mat       Packed population of cells.
+ * @param col       Source buffer.
+ * @param width     Row width in cells.
+ * @param len       Length of the source buffer.
+ * @param pos       Column number.
+ * @param offset    Offset to apply.
+ */
+void insert_packed_column(cell_word *mat, cell *col, unsigned int width, unsigned int len, unsigned int pos,
+                          unsigned int offset) {
+    unsigned int words = get_row_words(width);
+
+    for (unsigned int i = 0; i < len; i++) {
+        set_packed_cell(mat, i + offset, pos, words, col[i]);
+    }
+}
+
+/**
+ * Copies upper halo of packed population into a buffer of cells.
+ *
+ * @param mat       Packed population of cells.
+ * @param buf       Target buffer.
+ * @param height    Augmented height.
+ * @param width     Augmented width.
+ */
+void copy_packed_upper_halo(cell_word *mat, cell *buf, unsigned int height, unsigned int width) {
+    copy_packed_row(mat, buf, width, width - 2, 1, 1);
+}
+
+/**
+ * Copies lower halo of packed population into a buffer of cells.
+ *
+ * @param mat       Packed population of cells.
+ * @param buf       Target buffer.
+ * @param height    Augmented height.
+ * @param width     Augmented width.
+ */
+void copy_packed_lower_halo(cell_word *mat, cell *buf, unsigned int height, unsigned int width) {
+    copy_packed_row(mat, buf, width, width - 2, height - 2, 1);
+}
+
+/**
+ * Copies left halo of packed population into a buffer of cells.
+ *
+ * @param mat       Packed population of cells.
+ * @param buf       Target buffer.
+ * @param height    Augmented height.
+ * @param width     Augmented width.
+ */
+void copy_packed_left_halo(cell_word *mat, cell *buf, unsigned int height, unsigned int width) {
+    copy_packed_column(mat, buf, width, height - 2, 1, 1);
+}
+
+/**
+ * Copies right halo of packed population into a buffer of cells.
+ *
+ * @param mat       Packed population of cells.
+ * @param buf       Target buffer.
+ * @param height    Augmented height.
+ * @param width     Augmented width.
+ */
+void copy_packed_right_halo(cell_word *mat, cell *buf, unsigned int height, unsigned int width) {
+    copy_packed_column(mat, buf, width, height - 2, width - 2, 1);
+}
+
+/**
+ * Inserts received halos into packed population.
+ *
+ * @param mat       Packed population of cells.
+ * @param up        Upper halo.
+ * @param down      Lower halo.
+ * @param left      Left halo.
+ * @param right     Right halo.
+ * @param height    Augmented height.
+ * @param width     Augmented width.
+ */
+void insert_packed_halos(cell_word *mat, cell *up, cell *down, cell *left, cell *right, unsigned int height,
+                         unsigned int width) {
+    insert_packed_column(mat, left, width, height - 2, 0, 1);
+    insert_packed_column(mat, right, width, height - 2, width - 1, 1);
+    insert_packed_row(mat, up, width, width - 2, 0, 1);
+    insert_packed_row(mat, down, width, width - 2, height - 1, 1);
+}
+
+/**
+ * Fills left and right halos of packed population with its own right and left boundary.
+ *
+ * @param mat       Packed population of cells.
+ * @param height    Augmented height.
+ * @param width     Augmented width.
+ */
+void wrap_packed_column_halos(cell_word *mat, unsigned int height, unsigned int width) {
+    unsigned int words = get_row_words(width);
+
+    for (unsigned int i = 1; i < height - 1; i++) {
+        set_packed_cell(mat, i, 0, words, get_packed_cell(mat, i, width - 2, words));
+        set_packed_cell(mat, i, width - 1, words, get_packed_cell(mat, i, 1, words));
+    }
+}
+
+/**
+ * Fills upper and lower halos of packed population with its own lower and upper boundary.
+ *
+ * @param mat       Packed population of cells.
+ * @param height    Augmented height.
+ * @param width     Augmented width.
+ */
+void wrap_packed_row_halos(cell_word *mat, unsigned int height, unsigned int width) {
+    unsigned int words = get_row_words(width);
+
+    for (unsigned int k = 0; k < words; k++) {
+        mat[k] = mat[(height - 2) * words + k];
+        mat[(height - 1) * words + k] = mat[words + k];
+    }
+}
+
+/**
+ * Initializes augmented packed population of cells using default strategy. Cells are drawn the same way as in
+ * randomize_augmented_population, so both storage modes start from identical populations for a given seed.
+ *
+ * @param mat           Packed population of cells, zero initialized.
+ * @param height        Height of the population.
+ * @param width         Width of the population.
+ * @param p             Probability of a cell being alive.
+ * @param seed          Population seed.
+ * @param row_offset    Global row of the first row of the population without halos.
+ * @param col_offset    Global column of the first column of the population without halos.
+ * @param global_width  Width of the global population.
+ * @return              Total number of live cells.
+ */
+unsigned long long randomize_packed_population(cell_word *mat, unsigned int height, unsigned int width, float p,
+                                               unsigned int seed, unsigned int row_offset, unsigned int col_offset,
+                                               unsigned int global_width) {
+    unsigned long long alive = 0;
+    unsigned int words = get_row_words(width);
+    unsigned long long key = mix_hash(seed);
+
+#pragma omp parallel for schedule(static) reduction(+:alive)
+    for (unsigned int i = 1; i < height - 1; i++) {
+        unsigned long long index = (unsigned long long) (row_offset + i - 1) * global_width + col_offset - 1;
+
+        for (unsigned int j = 1; j < width - 1; j++) {
+            cell value = fuzzer(p, key, index + j);
+            set_packed_cell(mat, i, j, words, value);
+            alive += value;
+        }
+    }
+
+    return alive;
+}
+
+/**
+ * Computes position-aware hash of a packed population, equal to the hash of the same population unpacked. Live cells
+ * are visited by scanning set bits of interior words.
+ *
+ * @param mat           Packed population of cells.
+ * @param height        Height of the population.
+ * @param width         Width of the population.
+ * @param row_offset    Global row of the first row of the population without halos.
+ * @param col_offset    Global column of the first column of the population without halos.
+ * @param global_width  Width of the global population.
+ * @return              Population hash.
+ */
+unsigned long long hash_packed_population(cell_word *mat, unsigned int height, unsigned int width,
+                                          unsigned int row_offset, unsigned int col_offset, unsigned int global_width) {
+    unsigned long long hash = 0;
+    unsigned int words = get_row_words(width);
+    unsigned long long *col_hashes = malloc((width - 2) * sizeof(unsigned long long));
+
+    init_column_hashes(col_hashes, col_offset, width - 2);
+
+#pragma omp parallel for schedule(static) reduction(+:hash)
+    for (unsigned int i = 1; i < height - 1; i++) {
+        unsigned long long row_hash = 0;
+
+        for (unsigned int k = 0; k < words; k++) {
+            cell_word live = mat[i * words + k] & get_interior_mask(k, words, width);
+
+            while (live) {
+                row_hash += col_hashes[k * CELLS_PER_WORD + __builtin_ctzll(live) - 1];
+                live &= live - 1;
+            }
+        }
+
+        hash += get_row_hash(row_offset + i - 1, global_width) * row_hash;
+    }
+
+    free(col_hashes);
+
+    return hash;
+}
+
+/**
+ * Packed kernel definition. Packed kernel computes next generation of a packed population for a single rule
+ * specialized at compile time.
+ */
+typedef void (*packed_kernel)(
+        cell_word *mat,
+        cell_word *buf,
+        unsigned long long *cells_alive,
+        unsigned long long *cells_delta,
+        unsigned int height,
+        unsigned int width
+);
+
+
+/**
+ * Computes the next state of 64 cells at once. The five inputs are summed with word-wide boolean adders into a 3-bit
+ * bit-sliced counter (s2, s1, s0), and the rule is applied as a union of the counter minterms it selects. Since the sum
+ * never exceeds 5, s2 implies s1 is clear.
+ *
+ * @param c     Cells.
+ * @param w     Western neighbours.
+ * @param e     Eastern neighbours.
+ * @param n     Northern neighbours.
+ * @param s     Southern neighbours.
+ * @param rule  Rule bitmask, compile-time constant.
+ * @return      Next state.
+ */
+static ALWAYS_INLINE cell_word update_packed_cells(
+        cell_word c,
+        cell_word w,
+        cell_word e,
+        cell_word n,
+        cell_word s,
+        unsigned int rule
+) {
+    // Full adder over (c, w, e) and half adder over (n, s).
+    cell_word ones_a = c ^ w ^ e;
+    cell_word twos_a = (c & w) | (c & e) | (w & e);
+    cell_word ones_b = n ^ s;
+    cell_word twos_b = n & s;
+
+    // Combine partial sums.
+    cell_word s0 = ones_a ^ ones_b;
+    cell_word carry = ones_a & ones_b;
+    cell_word s1 = twos_a ^ twos_b ^ carry;
+    cell_word s2 = (twos_a & twos_b) | (twos_a & carry) | (twos_b & carry);
+
+    cell_word state = 0;
+
+    if (rule & (1u << 0)) state |= ~s2 & ~s1 & ~s0;
+    if (rule & (1u << 1)) state |= ~s2 & ~s1 & s0;
+    if (rule & (1u << 2)) state |= ~s2 & s1 & ~s0;
+    if (rule & (1u << 3)) state |= ~s2 & s1 & s0;
+    if (rule & (1u << 4)) state |= s2 & ~s0;
+    if (rule & (1u << 5)) state |= s2 & s0;
+
+    return state;
+}
+
+/**
+ * Computes state of the simulation at next time step using augmented packed population of cells. Behaves exactly like
+ * update_population with the same rule, but processes a whole word of cells per operation and counts live and changed
+ * cells with popcount. Halo cells of the buffer are left untouched.
+ *
+ * @param mat           Packed augmented population of cells.
+ * @param buf           Packed buffer that will contain augmented population at next time step.
+ * @param cells_alive   Number of live cells at next time step.
+ * @param cells_delta   Number of cells that changed state.
+ * @param height        Height of the augmented population.
+ * @param width         Width of the augmented population in cells.
+ * @param rule          Rule bitmask, compile-time constant.
+ * @param count         If false, counters are left untouched, compile-time constant.
+ */
+static ALWAYS_INLINE void update_packed_population_template(
+        cell_word *mat,
+        cell_word *buf,
+        unsigned long long *cells_alive,
+        unsigned long long *cells_delta,
+        unsigned int height,
+        unsigned int width,
+        unsigned int rule,
+        bool count
+) {
+    unsigned long long delta = 0, alive = 0;
+    unsigned int words = get_row_words(width);
+
+#pragma omp parallel for schedule(static) reduction(+:alive, delta)
+    for (unsigned int i = 1; i < height - 1; i++) {
+        cell_word *row = &mat[i * words];
+
+        for (unsigned int k = 0; k < words; k++) {
+            cell_word c = row[k];
+            cell_word prev = (k > 0) ? row[k - 1] : 0;
+            cell_word next = (k + 1 < words) ? row[k + 1] : 0;
+
+            cell_word state = update_packed_cells(
+                    c,
+                    (c << 1) | (prev >> (CELLS_PER_WORD - 1)),
+                    (c >> 1) | (next << (CELLS_PER_WORD - 1)),
+                    mat[(i - 1) * words + k],
+                    mat[(i + 1) * words + k],
+                    rule
+            );
+
+            cell_word mask = get_interior_mask(k, words, width);
+            state &= mask;
+
+            if (count) {
+                alive += __builtin_popcountll(state);
+                delta += __builtin_popcountll(state ^ (buf[i * words + k] & mask));
+            }
+
+            buf[i * words + k] = state | (buf[i * words + k] & ~mask);
+        }
+    }
+
+    if (count) {
+        *cells_alive = alive;
+        *cells_delta = delta;
+    }
+}
+
+/**
+ * Generates packed kernels specialized for a single rule, and their uncounted variants that skip counting live and
+ * changed cells.
+ */
+#define PACKED_KERNEL_PARAMS \
+        cell_word *mat, cell_word *buf, unsigned long long *cells_alive, unsigned long long *cells_delta, \
+        unsigned int height, unsigned int width
+#define DEFINE_PACKED_KERNEL(RULE) \
+    void update_packed_population_##RULE(PACKED_KERNEL_PARAMS) { \
+        update_packed_population_template(mat, buf, cells_alive, cells_delta, height, width, RULE, true); \
+    } \
+    void update_packed_population_uncounted_##RULE(PACKED_KERNEL_PARAMS) { \
+        update_packed_population_template(mat, buf, cells_alive, cells_delta, height, width, RULE, false); \
+    }
+#define PACKED_KERNEL_ENTRY(RULE) &update_packed_population_##RULE,
+#define UNCOUNTED_PACKED_KERNEL_ENTRY(RULE) &update_packed_population_uncounted_##RULE,
+
+FOR_EACH_RULE(DEFINE_PACKED_KERNEL)
+
+const packed_kernel packed_kernels[RULE_COUNT] = {FOR_EACH_RULE(PACKED_KERNEL_ENTRY)};
+const packed_kernel uncounted_packed_kernels[RULE_COUNT] = {FOR_EACH_RULE(UNCOUNTED_PACKED_KERNEL_ENTRY)};
+
+/**
+ * Computes state of the simulation at next time step using augmented packed population of cells and the default rule.
+ *
+ * @param mat           Packed augmented population of cells.
+ * @param buf           Packed buffer that will contain augmented population at next time step.
+ * @param cells_alive   Number of live cells at next time step.
+ * @param cells_delta   Number of cells that changed state.
+ * @param height        Height of the augmented population.
+ * @param width         Width of the augmented population in cells.
+ */
+void update_packed_population(
+        cell_word *mat,
+        cell_word *buf,
+        unsigned long long *cells_alive,
+        unsigned long long *cells_delta,
+        unsigned int height,
+        unsigned int width
+) {
+    update_packed_population_template(mat, buf, cells_alive, cells_delta, height, width, MPP_RULE, true);
+}
+
+
+#endif //MPP_AUTOMATON_PACKED_POPULATION_H
@@ -4,8 +4,13 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <string.h>
 #include <math.h>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 #define UP 0
 #define RIGHT 1
 #define DOWN 2
@@ -19,6 +24,27 @@
 typedef char cell;
 
 
+/**
+ * Minimum number of cells in a halo row or column for its copy to be split across threads. Shorter halos are copied by
+ * a single thread, since forking costs more than the copy itself.
+ */
+#define PARALLEL_HALO_LEN 4096
+
+
+/**
+ * Returns number of threads used by parallel regions.
+ *
+ * @return  Number of threads, 1 if compiled without OpenMP.
+ */
+static inline int get_thread_count() {
+#ifdef _OPENMP
+    return omp_get_max_threads();
+#else
+    return 1;
+#endif
+}
+
+
 /**
  * Inserts column into 2D array in-place using offset. Unsafe - results in segmentation fault if insertion index falls
  * outside array boundaries.
@@ -31,6 +57,7 @@ typedef char cell;
  * @param offset    Offset to be added.
  */
 void insert_column(cell *mat, cell *col, unsigned int width, unsigned int len, unsigned int pos, unsigned int offset) {
+#pragma omp parallel for schedule(static) if (len >= PARALLEL_HALO_LEN)
     for (unsigned int i = 0; i < len; i++) {
         mat[(i + offset) * width + pos] = col[i];
     }
@@ -48,6 +75,7 @@ void insert_column(cell *mat, cell *col, unsigned int width, unsigned int len, u
  * @param offset    Offset to be added.
  */
 void insert_row(cell *mat, cell *col, unsigned int width, unsigned int len, unsigned int pos, unsigned int offset) {
+#pragma omp parallel for schedule(static) if (len >= PARALLEL_HALO_LEN)
     for (unsigned int i = 0; i < len; i++) {
         mat[pos * width + i + offset] = col[i];
     }
@@ -114,6 +142,7 @@ void insert_right_halo(cell *mat, cell *halo, unsigned int width, unsigned int l
  * @return          Pointer to 1D array representing single column.
  */
 void copy_column(cell *mat, cell *col, unsigned int width, unsigned int len, unsigned int pos, unsigned int offset) {
+#pragma omp parallel for schedule(static) if (len >= PARALLEL_HALO_LEN)
     for (unsigned int i = 0; i < len; i++) {
         col[i] = mat[(i + offset) * width + pos];
     }
@@ -131,6 +160,7 @@ void copy_column(cell *mat, cell *col, unsigned int width, unsigned int len, uns
  * @return          Pointer to 1D array representing single row.
  */
 void copy_row(cell *mat, cell *row, unsigned int width, unsigned int len, unsigned int pos, unsigned int offset) {
+#pragma omp parallel for schedule(static) if (len >= PARALLEL_HALO_LEN)
     for (unsigned int i = 0; i < len; i++) {
         row[i] = mat[pos * width + i + offset];
     }
@@ -183,13 +213,51 @@ void copy_right_halo(cell *mat, cell *buf, unsigned int height, unsigned width)
     copy_column(mat, buf, width, height - 2, width - 2, 1);
 }
 
+/**
+ * Extracts rectangular block from 2D array into a contiguous buffer. This function is unsafe, and will result in
+ * segmentation fault if requested block falls outside the array boundary.
+ *
+ * @param mat       2D array.
+ * @param buf       Target buffer of rows * cols cells.
+ * @param width     Row width.
+ * @param rows      Number of rows in the block.
+ * @param cols      Number of columns in the block.
+ * @param row       First row of the block.
+ * @param col       First column of the block.
+ */
+void copy_block(cell *mat, cell *buf, unsigned int width, unsigned int rows, unsigned int cols, unsigned int row,
+                unsigned int col) {
+    for (unsigned int i = 0; i < rows; i++) {
+        copy_row(mat, &buf[i * cols], width, cols, row + i, col);
+    }
+}
+
+/**
+ * Inserts contiguous buffer into 2D array as a rectangular block. This function is unsafe, and will result in
+ * segmentation fault if the block falls outside the array boundary.
+ *
+ * @param mat       2D array.
+ * @param buf       Source buffer of rows * cols cells.
+ * @param width     Row width.
+ * @param rows      Number of rows in the block.
+ * @param cols      Number of columns in the block.
+ * @param row       First row of the block.
+ * @param col       First column of the block.
+ */
+void insert_block(cell *mat, cell *buf, unsigned int width, unsigned int rows, unsigned int cols, unsigned int row,
+                  unsigned int col) {
+    for (unsigned int i = 0; i < rows; i++) {
+        insert_row(mat, &buf[i * cols], width, cols, row + i, col);
+    }
+}
+
 /**
  * Returns cell's next state given the sum of cell's value and it's nearest neighbours.
  *
  * @param sum   Sum of nearest neighbours.
  * @return      Next state.
  */
-inline cell mpp_update_cell(cell sum) {
+static inline cell mpp_update_cell(cell sum) {
     return (sum == 2 || sum == 4 || sum == 5) ? 1 : 0;
 }
 
@@ -202,7 +270,7 @@ inline cell mpp_update_cell(cell sum) {
  * @param w     Row width.
  * @return      Sum of cell's value and its nearest neighbours.
  */
-inline cell mpp_compute_state_sum(cell *mat, unsigned int i, unsigned int j, unsigned int w) {
+static inline cell mpp_compute_state_sum(cell *mat, unsigned int i, unsigned int j, unsigned int w) {
     return mat[i * w + j] + mat[i * w + j - 1] + mat[i * w + j + 1] + mat[(i - 1) * w + j] + mat[(i + 1) * w + j];
 }
 
@@ -227,11 +295,11 @@ void update_population(
         cell (*state_fn_ptr)(cell *, unsigned int, unsigned int, unsigned int)
 ) {
     unsigned long long delta = 0, alive = 0;
-    cell next_state;
 
+#pragma omp parallel for schedule(static) reduction(+:alive, delta)
     for (unsigned int i = 1; i < height - 1; i++) {
         for (unsigned int j = 1; j < width - 1; j++) {
-            next_state = update_fn_ptr(state_fn_ptr(mat, i, j, width));
+            cell next_state = update_fn_ptr(state_fn_ptr(mat, i, j, width));
             alive += next_state;
 
             if (buf[i * width + j] != next_state) {
@@ -252,58 +320,77 @@ void update_population(
  * @param mat       Augmented population of cells.
  * @param height    Height of the population.
  * @param width     Width of the population.
+ * @param halo      Halo depth.
  */
-void reset_halos(cell *pop, unsigned int height, unsigned int width) {
-    unsigned int i;
-
-    // Reset columns
-    for (i = 0; i < height; i++) {
-        pop[i * width] = 0;                 // First column
-        pop[i * width + width - 1] = 0;     // Last column
-    }
+void reset_halos(cell *pop, unsigned int height, unsigned int width, unsigned int halo) {
+    unsigned int i, k;
+
+    for (k = 0; k < halo; k++) {
+        // Reset columns
+        for (i = 0; i < height; i++) {
+            pop[i * width + k] = 0;                 // First columns
+            pop[i * width + width - 1 - k] = 0;     // Last columns
+        }
 
-    // Reset rows
-    for (i = 0; i < width; i++) {
-        pop[i] = 0;                 // First row
-        pop[(height - 1) * width + i] = 0;                  // Last row
+        // Reset rows
+        for (i = 0; i < width; i++) {
+            pop[k * width + i] = 0;                         // First rows
+            pop[(height - 1 - k) * width + i] = 0;          // Last rows
+        }
     }
 }
 
-
 /**
- * Draws samples from uniform distribution.
+ * Fills left and right halos of augmented population of cells with its own right and left boundary. Used when a process
+ * is its own left and right neighbour.
  *
- * @return  Float in the range [0, 1] sampled from uniform distribution.
+ * @param mat       Augmented population of cells.
+ * @param height    Height of the population.
+ * @param width     Width of the population.
+ * @param halo      Halo depth.
  */
-static inline float uniform() {
-    return (float) rand() / (float) (RAND_MAX);
+void wrap_column_halos(cell *mat, unsigned int height, unsigned int width, unsigned int halo) {
+#pragma omp parallel for schedule(static) if (height >= PARALLEL_HALO_LEN)
+    for (unsigned int i = halo; i < height - halo; i++) {
+        for (unsigned int k = 0; k < halo; k++) {
+            mat[i * width + k] = mat[i * width + width - 2 * halo + k];     // Left halo
+            mat[i * width + width - halo + k] = mat[i * width + halo + k];  // Right halo
+        }
+    }
 }
 
 /**
- * Wraps default population initialization strategy.
+ * Fills upper and lower halos of augmented population of cells with its own lower and upper boundary, across the whole
+ * augmented width so that corners are wrapped too. Used when a process is its own upper and lower neighbour.
  *
- * @param p Probability of a cell being alive.
- * @return  Cell.
+ * @param mat       Augmented population of cells.
+ * @param height    Height of the population.
+ * @param width     Width of the population.
+ * @param halo      Halo depth.
  */
-static inline cell fuzzer(float p) {
-    return (uniform() < p) ? 1 : 0;
+void wrap_row_halos(cell *mat, unsigned int height, unsigned int width, unsigned int halo) {
+#pragma omp parallel for schedule(static) if (halo * width >= PARALLEL_HALO_LEN)
+    for (unsigned int i = 0; i < halo * width; i++) {
+        mat[i] = mat[(height - 2 * halo) * width + i];                      // Upper halo
+        mat[(height - halo) * width + i] = mat[halo * width + i];           // Lower halo
+    }
 }
 
 /**
- * Initializes augmented population of cells using default strategy.
+ * Counts live cells of augmented population, excluding halos.
  *
  * @param mat       Augmented population of cells.
  * @param height    Height of the population.
  * @param width     Width of the population.
- * @param p         Probability of a cell being alive.
- * @return          Total number of live cells.
+ * @param halo      Halo depth.
+ * @return          Number of live cells.
  */
-unsigned long long randomize_augmented_population(cell *mat, unsigned int height, unsigned int width, float p) {
+unsigned long long count_live_cells(cell *mat, unsigned int height, unsigned int width, unsigned int halo) {
     unsigned long long alive = 0;
 
-    for (unsigned int i = 1; i < height - 1; i++) {
-        for (unsigned int j = 1; j < width - 1; j++) {
-            mat[i * width + j] = fuzzer(p);
+#pragma omp parallel for schedule(static) reduction(+:alive)
+    for (unsigned int i = halo; i < height - halo; i++) {
+        for (unsigned int j = halo; j < width - halo; j++) {
             alive += mat[i * width + j];
         }
     }
@@ -312,18 +399,169 @@ unsigned long long randomize_augmented_population(cell *mat, unsigned int height
 }
 
 /**
- * Generates random augmented population of cells using uniform distribution.
+ * Mixes a 64-bit value with the finalizer of splitmix64, so that hashes of consecutive values are unrelated.
  *
- * @param height    Height of the population.
- * @param width     Width of the population.
- * @param p         Probability of a cell being alive.
- * @return          Pointer representing augmented population of cells.
+ * @param value Value to be hashed.
+ * @return      Hash.
  */
-unsigned long long random_augmented_population(cell *buf, unsigned int height, unsigned int width, float p) {
-//    cell *population = malloc((height + 2) * (width + 2) * sizeof(cell));
+static inline unsigned long long mix_hash(unsigned long long value) {
+    unsigned long long z = value + 0x9e3779b97f4a7c15ull;
+
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+
+    return z ^ (z >> 31);
+}
 
-    unsigned long long live_cell_count = randomize_augmented_population(buf, height, width, p);
-    reset_halos(buf, height, width);
+/**
+ * Computes hash of a global row. Row hashes are odd, so that a change confined to a single row always changes the
+ * population hash unless it cancels out within the row.
+ *
+ * @param row           Global row.
+ * @param global_width  Width of the global population, which separates row hashes from column hashes.
+ * @return              Row hash.
+ */
+static inline unsigned long long get_row_hash(unsigned int row, unsigned int global_width) {
+    return mix_hash((unsigned long long) global_width + row) | 1;
+}
+
+/**
+ * Computes hashes of a range of global columns.
+ *
+ * @param col_hashes    Target buffer of len hashes.
+ * @param col_offset    First global column.
+ * @param len           Number of columns.
+ */
+void init_column_hashes(unsigned long long *col_hashes, unsigned int col_offset, unsigned int len) {
+    for (unsigned int j = 0; j < len; j++) {
+        col_hashes[j] = mix_hash(col_offset + j);
+    }
+}
+
+/**
+ * Computes position-aware hash of a population as the sum of hashes of its live cells modulo 2^64, where the hash of a
+ * cell is the product of hashes of its global row and column. Hashes of partitions add up to the hash of the global
+ * population, so they are combined with the same reduction as live cell counts and the result doesn't depend on the
+ * decomposition. Each row is hashed with a single multiplication, and hashes of dead cells are masked out rather than
+ * skipped, so that the inner loop is vectorized.
+ *
+ * @param mat           Augmented population of cells.
+ * @param height        Height of the population.
+ * @param width         Width of the population.
+ * @param halo          Halo depth.
+ * @param row_offset    Global row of the first row of the population without halos.
+ * @param col_offset    Global column of the first column of the population without halos.
+ * @param global_width  Width of the global population.
+ * @return              Population hash.
+ */
+unsigned long long hash_population(cell *mat, unsigned int height, unsigned int width, unsigned int halo,
+                                   unsigned int row_offset, unsigned int col_offset, unsigned int global_width) {
+    unsigned int cols = width - 2 * halo;
+    unsigned long long hash = 0;
+    unsigned long long *col_hashes = malloc(cols * sizeof(unsigned long long));
+
+    init_column_hashes(col_hashes, col_offset, cols);
+
+#pragma omp parallel for schedule(static) reduction(+:hash)
+    for (unsigned int i = halo; i < height - halo; i++) {
+        cell *row = &mat[i * width + halo];
+        unsigned long long row_hash = 0;
+
+        for (unsigned int j = 0; j < cols; j++) {
+            row_hash += col_hashes[j] & -(unsigned long long) row[j];
+        }
+
+        hash += get_row_hash(row_offset + i - halo, global_width) * row_hash;
+    }
+
+    free(col_hashes);
+
+    return hash;
+}
+
+/**
+ * Draws state of a cell from uniform distribution. The sample is derived from the population key and global index of
+ * the cell alone, so that the population doesn't depend on the decomposition or the number of threads.
+ *
+ * @param p     Probability of a cell being alive.
+ * @param key   Population key, i.e. hash of the population seed.
+ * @param index Global index of the cell.
+ * @return      Cell.
+ */
+static inline cell fuzzer(float p, unsigned long long key, unsigned long long index) {
+    return ((float) (mix_hash(key + index) >> 40) / (float) (1 << 24) < p) ? 1 : 0;
+}
+
+/**
+ * Touches every page of a population from the threads that compute it, so that with a first-touch policy each thread's
+ * rows are placed on its local NUMA domain. Rows are distributed with the same static schedule as the update kernels
+ * and zero initialized.
+ *
+ * @param mat       Population of cells.
+ * @param height    Number of rows.
+ * @param row_size  Row size in bytes.
+ */
+void first_touch_population(void *mat, unsigned int height, size_t row_size) {
+#pragma omp parallel for schedule(static)
+    for (unsigned int i = 0; i < height; i++) {
+        memset((char *) mat + i * row_size, 0, row_size);
+    }
+}
+
+/**
+ * Initializes augmented population of cells using default strategy. Every cell is drawn from its global position, so
+ * rows are initialized in parallel by the threads that compute them, and partitions of a global population are equal
+ * regardless of the decomposition.
+ *
+ * @param mat           Augmented population of cells.
+ * @param height        Height of the population.
+ * @param width         Width of the population.
+ * @param halo          Halo depth.
+ * @param p             Probability of a cell being alive.
+ * @param seed          Population seed.
+ * @param row_offset    Global row of the first row of the population without halos.
+ * @param col_offset    Global column of the first column of the population without halos.
+ * @param global_width  Width of the global population.
+ * @return              Total number of live cells.
+ */
+unsigned long long randomize_augmented_population(cell *mat, unsigned int height, unsigned int width, unsigned int halo,
+                                                  float p, unsigned int seed, unsigned int row_offset,
+                                                  unsigned int col_offset, unsigned int global_width) {
+    unsigned long long alive = 0;
+    unsigned long long key = mix_hash(seed);
+
+#pragma omp parallel for schedule(static) reduction(+:alive)
+    for (unsigned int i = halo; i < height - halo; i++) {
+        unsigned long long index = (unsigned long long) (row_offset + i - halo) * global_width + col_offset - halo;
+
+        for (unsigned int j = halo; j < width - halo; j++) {
+            mat[i * width + j] = fuzzer(p, key, index + j);
+            alive += mat[i * width + j];
+        }
+    }
+
+    return alive;
+}
+
+/**
+ * Generates random augmented population of cells using uniform distribution.
+ *
+ * @param height        Height of the population.
+ * @param width         Width of the population.
+ * @param halo          Halo depth.
+ * @param p             Probability of a cell being alive.
+ * @param seed          Population seed.
+ * @param row_offset    Global row of the first row of the population without halos.
+ * @param col_offset    Global column of the first column of the population without halos.
+ * @param global_width  Width of the global population.
+ * @return              Pointer representing augmented population of cells.
+ */
+unsigned long long random_augmented_population(cell *buf, unsigned int height, unsigned int width, unsigned int halo,
+                                               float p, unsigned int seed, unsigned int row_offset,
+                                               unsigned int col_offset, unsigned int global_width) {
+    unsigned long long live_cell_count = randomize_augmented_population(buf, height, width, halo, p, seed, row_offset,
+                                                                        col_offset, global_width);
+    reset_halos(buf, height, width, halo);
 
     return live_cell_count;
 }
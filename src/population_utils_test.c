@@ -4,7 +4,15 @@
 
 #include "test_utils.h"
 #include "population_utils.h"
+#include "packed_population.h"
+#include "row_kernels.h"
+#include "tiled_population.h"
 #include "automaton.h"
+#include "load_balancer.h"
+#include "io.h"
+#include "checkpoint.h"
+#include "snapshot.h"
+#include "input.h"
 
 #define DEAD 0
 #define ALIVE 1
@@ -67,7 +75,7 @@ void TESTCASE_reset_halos() {
         buf[i] = i;
     }
 
-    reset_halos(buf, N, N);
+    reset_halos(buf, N, N, 1);
 
     cell left[M], right[M], up[M], down[M];
 
@@ -139,6 +147,57 @@ void TESTCASE_insert_halos() {
     all_equal(left, M, 4);
 }
 
+/**
+ *
+ */
+void TESTCASE_wrap_halos() {
+    unsigned int N = 6;
+    unsigned int k = 2;
+
+    cell buf[N * N];
+
+    for (int i = 0; i < N * N; i++) {
+        buf[i] = i;
+    }
+
+    wrap_column_halos(buf, N, N, k);
+    wrap_row_halos(buf, N, N, k);
+
+    // Halos hold the opposite boundary, including corners.
+    assert(buf[2 * N + 0] == 2 * N + 2);
+    assert(buf[3 * N + 5] == 3 * N + 3);
+    assert(buf[0 * N + 3] == 2 * N + 3);
+    assert(buf[5 * N + 2] == 3 * N + 2);
+    assert(buf[0 * N + 0] == 2 * N + 2);
+    assert(buf[5 * N + 5] == 3 * N + 3);
+}
+
+/**
+ *
+ */
+void TESTCASE_wrap_packed_halos() {
+    unsigned int N = 5;
+    unsigned int words = get_row_words(N);
+
+    cell_word buf[N * words];
+
+    for (int i = 0; i < N * words; i++) {
+        buf[i] = 0;
+    }
+
+    set_packed_cell(buf, 1, 1, words, 1);
+    set_packed_cell(buf, 3, 3, words, 1);
+
+    wrap_packed_column_halos(buf, N, N);
+    wrap_packed_row_halos(buf, N, N);
+
+    assert(get_packed_cell(buf, 1, 4, words) == 1);
+    assert(get_packed_cell(buf, 3, 0, words) == 1);
+    assert(get_packed_cell(buf, 4, 1, words) == 1);
+    assert(get_packed_cell(buf, 0, 3, words) == 1);
+    assert(get_packed_cell(buf, 0, 1, words) == 0);
+}
+
 /**
  *
  */
@@ -178,9 +237,610 @@ void TESTCASE_get_chunk_size_aligned() {
  *
  */
 void TESTCASE_get_side_length_misaligned() {
-    assert(get_side_length(7, 1, 2) == 4);
+    assert(get_side_length(7, 0, 2) == 4);
+    assert(get_side_length(7, 1, 2) == 3);
+    assert(get_side_length(11, 3, 4) == 2);
+}
+
+/**
+ *
+ */
+void TESTCASE_create_process_grid() {
+    int shape[2];
+
+    create_process_grid(6, 150, 150, shape);
+    assert(shape[0] == 3 && shape[1] == 2);
+
+    create_process_grid(4, 100, 400, shape);
+    assert(shape[0] == 1 && shape[1] == 4);
+
+    create_process_grid(4, 400, 100, shape);
+    assert(shape[0] == 4 && shape[1] == 1);
+
+    create_process_grid(4, 1, 3, shape);
+    assert(shape[0] == 0 && shape[1] == 0);
+}
+
+
+/**
+ *
+ */
+void TESTCASE_balance_cuts() {
+    int cuts[] = {0, 10, 20, 30}, new_cuts[4];
+
+    // Balanced load leaves cuts in place.
+    double balanced[] = {1, 1, 1};
+    balance_cuts(balanced, cuts, 3, 1, new_cuts);
+    assert(new_cuts[0] == 0 && new_cuts[1] == 10 && new_cuts[2] == 20 && new_cuts[3] == 30);
+
+    // Load concentrated in the first partition is split between all partitions.
+    double skewed[] = {3, 0, 0};
+    balance_cuts(skewed, cuts, 3, 1, new_cuts);
+    assert(new_cuts[0] == 0 && new_cuts[1] == 3 && new_cuts[2] == 7 && new_cuts[3] == 30);
+
+    // Partitions are kept at least min_len long.
+    balance_cuts(skewed, cuts, 3, 5, new_cuts);
+    assert(new_cuts[0] == 0 && new_cuts[1] == 5 && new_cuts[2] == 10 && new_cuts[3] == 30);
+}
+
+/**
+ *
+ */
+void TESTCASE_hash_population() {
+    unsigned int N = 10;
+    unsigned int M = 131;
+
+    cell buf[(N + 2) * (M + 2)], part[(N + 2) * (M + 2)];
+    cell_word packed[(N + 2) * get_row_words(M + 2)];
+
+    for (int i = 0; i < (N + 2) * (M + 2); i++) {
+        buf[i] = rand() % 2;
+    }
+
+    unsigned long long hash = hash_population(buf, N + 2, M + 2, 1, 0, 0, M);
+
+    // Hashes of quarters add up to the hash of the whole population.
+    unsigned int row_cuts[] = {0, 4, N}, col_cuts[] = {0, 70, M};
+    unsigned long long sum = 0;
+
+    for (int x = 0; x < 2; x++) {
+        for (int y = 0; y < 2; y++) {
+            unsigned int rows = row_cuts[x + 1] - row_cuts[x], cols = col_cuts[y + 1] - col_cuts[y];
+
+            copy_block(buf, part, M + 2, rows + 2, cols + 2, row_cuts[x], col_cuts[y]);
+            sum += hash_population(part, rows + 2, cols + 2, 1, row_cuts[x], col_cuts[y], M);
+        }
+    }
+
+    assert(sum == hash);
+
+    // Packed population has the same hash.
+    pack_population(buf, packed, N + 2, M + 2);
+    assert(hash_packed_population(packed, N + 2, M + 2, 0, 0, M) == hash);
+
+    // Moving a live cell changes the hash.
+    buf[M + 3] = ALIVE;
+    buf[M + 4] = DEAD;
+    hash = hash_population(buf, N + 2, M + 2, 1, 0, 0, M);
+
+    buf[M + 3] = DEAD;
+    buf[M + 4] = ALIVE;
+    assert(hash_population(buf, N + 2, M + 2, 1, 0, 0, M) != hash);
+}
+
+/**
+ *
+ */
+void TESTCASE_random_population() {
+    unsigned int N = 10;
+    unsigned int M = 131;
+
+    cell buf[(N + 2) * (M + 2)], part[(N + 2) * (M + 2)], block[(N + 2) * (M + 2)];
+    cell_word packed[(N + 2) * get_row_words(M + 2)];
+
+    unsigned long long alive = randomize_augmented_population(buf, N + 2, M + 2, 1, 0.5, 7, 0, 0, M);
+    assert(alive > 0 && alive < N * M);
+
+    // Partitions are equal to blocks of the global population.
+    unsigned int row_cuts[] = {0, 4, N}, col_cuts[] = {0, 70, M};
+    unsigned long long sum = 0;
+
+    for (int x = 0; x < 2; x++) {
+        for (int y = 0; y < 2; y++) {
+            unsigned int rows = row_cuts[x + 1] - row_cuts[x], cols = col_cuts[y + 1] - col_cuts[y];
+
+            sum += randomize_augmented_population(part, rows + 2, cols + 2, 1, 0.5, 7, row_cuts[x], col_cuts[y], M);
+            copy_block(buf, block, M + 2, rows, cols, row_cuts[x] + 1, col_cuts[y] + 1);
+
+            for (unsigned int i = 0; i < rows; i++) {
+                for (unsigned int j = 0; j < cols; j++) {
+                    assert(part[(i + 1) * (cols + 2) + j + 1] == block[i * cols + j]);
+                }
+            }
+        }
+    }
+
+    assert(sum == alive);
+
+    // Packed population is equal to unpacked population.
+    for (int i = 0; i < (N + 2) * get_row_words(M + 2); i++) {
+        packed[i] = 0;
+    }
+
+    assert(randomize_packed_population(packed, N + 2, M + 2, 0.5, 7, 0, 0, M) == alive);
+    assert(hash_packed_population(packed, N + 2, M + 2, 0, 0, M) == hash_population(buf, N + 2, M + 2, 1, 0, 0, M));
+
+    // Different seeds give different populations.
+    randomize_augmented_population(part, N + 2, M + 2, 1, 0.5, 8, 0, 0, M);
+    assert(hash_population(part, N + 2, M + 2, 1, 0, 0, M) != hash_population(buf, N + 2, M + 2, 1, 0, 0, M));
+}
+
+/**
+ *
+ */
+void TESTCASE_find_cycle() {
+    Arguments args = default_args();
+    args.cycle_window = 3;
+
+    SimulationData sim = {.args = &args, .cycle_count = 0};
+    unsigned long long history[2 * 3];
+    sim.cycle_history = history;
+
+    unsigned long long a[] = {5, 1, 11, 0}, b[] = {5, 1, 12, 0}, c[] = {6, 1, 11, 0}, d[] = {7, 1, 13, 0};
+    unsigned long long e[] = {7, 0, 13, 13};
+
+    // Populations with equal count but different hash, or equal hash but different count, are distinct.
+    assert(find_cycle(&sim, a) == 0);
+    assert(find_cycle(&sim, b) == 0);
+    assert(find_cycle(&sim, c) == 0);
+    assert(find_cycle(&sim, a) == 3);
+    assert(find_cycle(&sim, a) == 1);
+
+    // Populations older than the window are forgotten.
+    assert(find_cycle(&sim, d) == 0);
+    assert(find_cycle(&sim, b) == 0);
+    assert(find_cycle(&sim, c) == 0);
+    assert(find_cycle(&sim, b) == 2);
+
+    // Periods are counted in steps.
+    args.stats_interval = 4;
+    assert(find_cycle(&sim, c) == 8);
+
+    // Populations equal to the previous generation are fixed points, regardless of stats interval.
+    assert(find_cycle(&sim, e) == 1);
+}
+
+/**
+ *
+ */
+void TESTCASE_pack_pbm_row() {
+    cell row[] = {ALIVE, DEAD, DEAD, ALIVE, ALIVE, ALIVE, DEAD, ALIVE, DEAD, ALIVE, ALIVE};
+    unsigned char buf[2];
+
+    // Live cells are white, and padding bits are clear.
+    pack_pbm_row(row, 11, buf);
+    assert(buf[0] == 0x62 && buf[1] == 0x80);
+
+    pack_pbm_row(row, 8, buf);
+    assert(buf[0] == 0x62);
+
+    pack_pbm_row(row + 1, 2, buf);
+    assert(buf[0] == 0xc0);
+}
+
+/**
+ *
+ */
+void TESTCASE_format_pbm_row() {
+    cell row[] = {ALIVE, DEAD, DEAD};
+    char buf[6];
+
+    // Pixels are separated by spaces, and lines end after the last pixel of the image.
+    format_pbm_row(row, 3, 0, 3, buf);
+    assert(strncmp(buf, "0 1 1\n", 6) == 0);
+
+    // Lines are broken after every PIXELS_PER_LINE pixels.
+    format_pbm_row(row, 3, PIXELS_PER_LINE - 2, 2 * PIXELS_PER_LINE, buf);
+    assert(strncmp(buf, "0 1\n1 ", 6) == 0);
+}
+
+/**
+ *
+ */
+void TESTCASE_get_owned_pbm_bytes() {
+    int col_cuts[] = {0, 5, 7, 20};
+    unsigned int first_byte, n_bytes;
+
+    SimulationData sim = {.col_cuts = col_cuts};
+
+    // Bytes are owned by the partition holding their first pixel.
+    sim.y_coordinate = 0, sim.local_width = 5;
+    get_owned_pbm_bytes(&sim, &first_byte, &n_bytes);
+    assert(first_byte == 0 && n_bytes == 1);
+
+    // Partitions narrower than a byte may own none.
+    sim.y_coordinate = 1, sim.local_width = 2;
+    get_owned_pbm_bytes(&sim, &first_byte, &n_bytes);
+    assert(n_bytes == 0);
+
+    sim.y_coordinate = 2, sim.local_width = 13;
+    get_owned_pbm_bytes(&sim, &first_byte, &n_bytes);
+    assert(first_byte == 1 && n_bytes == 2);
+}
+
+/**
+ *
+ */
+void TESTCASE_format_snapshot_header() {
+    char header[SNAPSHOT_HEADER_LEN + 1] = {0};
+    unsigned int step;
+    int width, height, len = 0;
+
+    // Headers of all frames have the same length, and end with a single newline before the pixels.
+    format_snapshot_header(header, 2147483647, 2147483647, 4294967295u);
+    assert(strlen(header) == SNAPSHOT_HEADER_LEN);
+
+    format_snapshot_header(header, 17, 9, 100);
+    assert(strlen(header) == SNAPSHOT_HEADER_LEN);
+    assert(sscanf(header, "P4\n# step %u%*[ ]\n%d %d%n", &step, &width, &height, &len) == 3);
+    assert(step == 100 && width == 17 && height == 9);
+    assert(len == SNAPSHOT_HEADER_LEN - 1 && header[len] == '\n');
+}
+
+/**
+ *
+ */
+void TESTCASE_parse_checkpoint_header() {
+    unsigned long long fields[CHECKPOINT_FIELDS];
+
+    parse_checkpoint_header("P4\n# checkpoint step 100 lower 20 upper 45\n17 9\n\n ", fields);
+    assert(fields[CHECKPOINT_VALID]);
+    assert(fields[CHECKPOINT_STEP] == 100);
+    assert(fields[CHECKPOINT_LOWER] == 20 && fields[CHECKPOINT_UPPER] == 45);
+    assert(fields[CHECKPOINT_WIDTH] == 17 && fields[CHECKPOINT_HEIGHT] == 9);
+
+    // Pixels that look like whitespace are not part of the header.
+    assert(fields[CHECKPOINT_OFFSET] == 48);
+
+    // Plain images are not checkpoints.
+    parse_checkpoint_header("P4\n17 9\n", fields);
+    assert(!fields[CHECKPOINT_VALID]);
+
+    // Fields past a truncated header are zero.
+    parse_checkpoint_header("P4\n# checkpoint step 100 lower 20", fields);
+    assert(!fields[CHECKPOINT_VALID]);
+    assert(fields[CHECKPOINT_UPPER] == 0 && fields[CHECKPOINT_WIDTH] == 0 && fields[CHECKPOINT_HEIGHT] == 0);
+}
+
+/**
+ *
+ */
+void TESTCASE_parse_input_header() {
+    unsigned long long fields[INPUT_FIELDS];
+
+    parse_input_header("P1\n# comment\n17 # width\n9\n0 1", fields);
+    assert(fields[INPUT_VALID] && fields[INPUT_FORMAT] == INPUT_ASCII_PBM);
+    assert(fields[INPUT_WIDTH] == 17 && fields[INPUT_HEIGHT] == 9 && fields[INPUT_OFFSET] == 26);
+
+    parse_input_header("P4 17 9\n\n", fields);
+    assert(fields[INPUT_VALID] && fields[INPUT_FORMAT] == INPUT_BINARY_PBM && fields[INPUT_OFFSET] == 8);
+
+    parse_input_header("#N glider\nx = 3, y = 3, rule = B3/S23\nbo$2bo$3o!", fields);
+    assert(fields[INPUT_VALID] && fields[INPUT_FORMAT] == INPUT_RLE);
+    assert(fields[INPUT_WIDTH] == 3 && fields[INPUT_HEIGHT] == 3 && fields[INPUT_OFFSET] == 38);
+
+    parse_input_header("#N glider\nbo$2bo$3o!", fields);
+    assert(!fields[INPUT_VALID]);
+}
+
+/**
+ *
+ */
+void TESTCASE_decode_rle() {
+    const char *tags = "bo$2bo$3o!";
+    unsigned long long expected[] = {1, 12, 20, 21, 22};
+
+    Arguments args = default_args();
+    args.width = args.height = 10;
+
+    unsigned long long pos[RLE_FIELDS] = {0}, fst[RLE_FIELDS] = {0}, snd[RLE_FIELDS] = {0};
+    CellList list = {NULL, 0, 0};
+
+    decode_rle(tags, 0, 9, pos, &args, &list);
+    assert(pos[RLE_ROW] == 2 && pos[RLE_COL] == 3);
+    assert(list.count == 5 && memcmp(list.cells, expected, sizeof(expected)) == 0);
+
+    // Chunks split within a run are composed into the same position, and decode the same cells.
+    int len = RLE_FIELDS;
+    decode_rle(tags, 0, 8, fst, &args, NULL);
+    decode_rle(tags, 8, 9, snd, &args, NULL);
+    assert(snd[RLE_COL] == 3 && !snd[RLE_NEWLINE]);
+
+    compose_rle_displacements(fst, snd, &len, NULL);
+    assert(memcmp(pos, snd, sizeof(pos)) == 0);
+
+    list.count = 0;
+    decode_rle(tags, 8, 9, fst, &args, &list);
+    assert(list.count == 3 && memcmp(list.cells, &expected[2], 3 * sizeof(unsigned long long)) == 0);
+
+    // Cells placed outside of the population are dropped.
+    args.input_offset[1] = 8;
+    list.count = 0;
+    pos[RLE_ROW] = pos[RLE_COL] = 0;
+    decode_rle(tags, 0, 9, pos, &args, &list);
+    assert(list.count == 3 && list.cells[0] == 9 && list.cells[2] == 29);
+
+    free(list.cells);
 }
 
+/**
+ *
+ */
+void TESTCASE_pack_population_roundtrip() {
+    unsigned int N = 7;
+    unsigned int M = 131;
+
+    cell buf[N * M], out[N * M];
+    cell_word packed[N * get_row_words(M)];
+
+    for (int i = 0; i < N * M; i++) {
+        buf[i] = rand() % 2;
+    }
+
+    pack_population(buf, packed, N, M);
+    unpack_population(packed, out, N, M);
+
+    for (int i = 0; i < N * M; i++) {
+        assert(buf[i] == out[i]);
+    }
+}
+
+/**
+ * Helper function that checks a row kernel against a reference row kernel on random populations.
+ *
+ * @param kernel    Row kernel to test.
+ * @param reference Reference row kernel.
+ * @param count     If false, kernel is uncounted and only next generation is checked.
+ */
+void check_row_kernel(row_kernel kernel, row_kernel reference, bool count) {
+    unsigned int widths[] = {3, 33, 66, 97, 200};
+    unsigned int N = 6;
+
+    for (int k = 0; k < 5; k++) {
+        unsigned int M = widths[k];
+        unsigned long long alive, delta, kernel_alive, kernel_delta;
+
+        cell mat[N * M], buf[N * M], out[N * M];
+
+        for (int i = 0; i < N * M; i++) {
+            mat[i] = rand() % 2;
+            buf[i] = rand() % 2;
+            out[i] = buf[i];
+        }
+
+        update_population_rows(mat, buf, &alive, &delta, N, M, reference);
+        update_population_rows(mat, out, &kernel_alive, &kernel_delta, N, M, kernel);
+
+        assert(!count || alive == kernel_alive);
+        assert(!count || delta == kernel_delta);
+
+        for (int i = 0; i < N * M; i++) {
+            assert(buf[i] == out[i]);
+        }
+    }
+}
+
+/**
+ * Helper function that checks a packed kernel against a reference row kernel on random populations.
+ *
+ * @param kernel    Packed kernel to test.
+ * @param reference Reference row kernel.
+ * @param count     If false, kernel is uncounted and only next generation is checked.
+ */
+void check_packed_kernel(packed_kernel kernel, row_kernel reference, bool count) {
+    unsigned int widths[] = {3, 64, 65, 66, 130};
+    unsigned int N = 9;
+
+    for (int k = 0; k < 5; k++) {
+        unsigned int M = widths[k];
+        unsigned long long alive, delta, packed_alive, packed_delta;
+
+        cell mat[N * M], buf[N * M], out[N * M];
+        cell_word packed_mat[N * get_row_words(M)], packed_buf[N * get_row_words(M)];
+
+        for (int i = 0; i < N * M; i++) {
+            mat[i] = rand() % 2;
+            buf[i] = rand() % 2;
+        }
+
+        pack_population(mat, packed_mat, N, M);
+        pack_population(buf, packed_buf, N, M);
+
+        update_population_rows(mat, buf, &alive, &delta, N, M, reference);
+        kernel(packed_mat, packed_buf, &packed_alive, &packed_delta, N, M);
+        unpack_population(packed_buf, out, N, M);
+
+        assert(!count || alive == packed_alive);
+        assert(!count || delta == packed_delta);
+
+        for (int i = 0; i < N * M; i++) {
+            assert(buf[i] == out[i]);
+        }
+    }
+}
+
+/**
+ *
+ */
+void TESTCASE_update_population_rows() {
+    unsigned int N = 6;
+    unsigned int M = 70;
+    unsigned long long alive, delta, rows_alive, rows_delta;
+
+    cell mat[N * M], buf[N * M], out[N * M];
+
+    for (int i = 0; i < N * M; i++) {
+        mat[i] = rand() % 2;
+        buf[i] = rand() % 2;
+        out[i] = buf[i];
+    }
+
+    update_population(mat, buf, &alive, &delta, N, M, &mpp_update_cell, &mpp_compute_state_sum);
+    update_population_rows(mat, out, &rows_alive, &rows_delta, N, M, scalar_row_kernels[MPP_RULE]);
+
+    assert(alive == rows_alive);
+    assert(delta == rows_delta);
+
+    for (int i = 0; i < N * M; i++) {
+        assert(buf[i] == out[i]);
+    }
+}
+
+/**
+ *
+ */
+void TESTCASE_update_row_kernels() {
+#ifdef __x86_64__
+    __builtin_cpu_init();
+
+    for (unsigned int rule = 0; rule < RULE_COUNT; rule++) {
+        if (__builtin_cpu_supports("avx2")) {
+            check_row_kernel(avx2_row_kernels[rule], scalar_row_kernels[rule], true);
+        }
+
+        if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")) {
+            check_row_kernel(avx512_row_kernels[rule], scalar_row_kernels[rule], true);
+        }
+    }
+#endif
+}
+
+/**
+ *
+ */
+void TESTCASE_update_uncounted_row_kernels() {
+    for (unsigned int rule = 0; rule < RULE_COUNT; rule++) {
+        check_row_kernel(scalar_uncounted_row_kernels[rule], scalar_row_kernels[rule], false);
+        check_row_kernel(select_row_kernel_variant(rule, false), scalar_row_kernels[rule], false);
+        check_packed_kernel(uncounted_packed_kernels[rule], scalar_row_kernels[rule], false);
+    }
+}
+
+/**
+ *
+ */
+void TESTCASE_update_packed_kernels() {
+    for (unsigned int rule = 0; rule < RULE_COUNT; rule++) {
+        check_packed_kernel(packed_kernels[rule], scalar_row_kernels[rule], true);
+    }
+}
+
+/**
+ *
+ */
+void TESTCASE_update_population_tiles() {
+    unsigned int tile_sizes[] = {1, 4, 7, 64};
+    unsigned int N = 20, M = 37, K = 3;
+    unsigned long long alive, delta;
+
+    StepRegion regions[K];
+
+    for (unsigned int j = 0; j < K; j++) {
+        StepRegion region = {j + 1, N - j - 1, j + 1, M - j - 1, scalar_row_kernels[MPP_RULE]};
+        regions[j] = region;
+    }
+
+    for (int k = 0; k < 4; k++) {
+        cell mat[N * M], buf[N * M], tiled_mat[N * M], tiled_buf[N * M];
+
+        for (int i = 0; i < N * M; i++) {
+            mat[i] = tiled_mat[i] = rand() % 2;
+            buf[i] = tiled_buf[i] = rand() % 2;
+        }
+
+        TileGrid *grid = init_tile_grid(N, M, tile_sizes[k], K, false);
+
+        update_population_tiles(grid, tiled_mat, tiled_buf, N, M, K, regions, K);
+
+        for (unsigned int j = 0; j < K; j++) {
+            update_population_region((j % 2 == 0) ? mat : buf, (j % 2 == 0) ? buf : mat, &alive, &delta, N, M, K,
+                                     regions[j].top, regions[j].bottom, regions[j].left, regions[j].right,
+                                     regions[j].update_row_fn_ptr);
+
+            assert(alive == grid->step_alive[j]);
+            assert(delta == grid->step_delta[j]);
+        }
+
+        for (int i = 0; i < N * M; i++) {
+            assert(mat[i] == tiled_mat[i]);
+            assert(buf[i] == tiled_buf[i]);
+        }
+
+        free_tile_grid(grid);
+    }
+}
+
+/**
+ *
+ */
+void TESTCASE_track_tile_activity() {
+    unsigned int N = 30, M = 40, STEPS = 12;
+    unsigned long long alive, delta;
+
+    cell fst[N * M], snd[N * M], tracked_fst[N * M], tracked_snd[N * M];
+    cell *mat = fst, *buf = snd, *tracked_mat = tracked_fst, *tracked_buf = tracked_snd, *tmp;
+
+    StepRegion region = {1, N - 1, 1, M - 1, scalar_row_kernels[MPP_RULE]};
+
+    // Sparse population in a corner, the rest of the population stays quiet.
+    for (int i = 0; i < N * M; i++) {
+        fst[i] = tracked_fst[i] = (i < 5 * M && rand() % 3 == 0) ? 1 : 0;
+        snd[i] = tracked_snd[i] = 0;
+    }
+
+    TileGrid *grid = init_tile_grid(N, M, 5, 1, true);
+
+    for (unsigned int k = 0; k < STEPS; k++) {
+        save_halo_ring(grid, tracked_mat, N, M);
+
+        // Flip a halo cell far from live cells.
+        if (k == 6) {
+            mat[(N - 1) * M + 20] = tracked_mat[(N - 1) * M + 20] = 1;
+        }
+
+        mark_changed_halos(grid, tracked_mat, N, M);
+
+        update_population_region(mat, buf, &alive, &delta, N, M, 1, region.top, region.bottom, region.left,
+                                 region.right, region.update_row_fn_ptr);
+        update_population_tiles(grid, tracked_mat, tracked_buf, N, M, 1, &region, 1);
+
+        assert(alive == grid->step_alive[0]);
+        assert(delta == grid->step_delta[0]);
+
+        for (int i = 0; i < N * M; i++) {
+            assert(buf[i] == tracked_buf[i]);
+        }
+
+        tmp = mat, mat = buf, buf = tmp;
+        tmp = tracked_mat, tracked_mat = tracked_buf, tracked_buf = tmp;
+    }
+
+    free_tile_grid(grid);
+}
+
+/**
+ *
+ */
+void TESTCASE_parse_rule() {
+    unsigned int rule;
+
+    assert(parse_rule("2,4,5", &rule) == true && rule == MPP_RULE);
+    assert(parse_rule("0", &rule) == true && rule == 1);
+    assert(parse_rule("6", &rule) == false);
+    assert(parse_rule("2,", &rule) == false);
+    assert(parse_rule("2;4", &rule) == false);
+    assert(parse_rule("", &rule) == false);
+}
 
 int main(int argc, char const *argv[]) {
     TESTCASE_update_cell_alive();
@@ -189,12 +849,34 @@ int main(int argc, char const *argv[]) {
     TESTCASE_compute_state_sum_zero();
     TESTCASE_compute_state_sum_five();
     TESTCASE_insert_halos();
+    TESTCASE_wrap_halos();
+    TESTCASE_wrap_packed_halos();
     TESTCASE_check_lower_threshold_pos();
     TESTCASE_check_lower_threshold_neg();
     TESTCASE_check_upper_threshold_pos();
     TESTCASE_check_upper_threshold_neg();
     TESTCASE_check_upper_threshold_neg();
     TESTCASE_get_side_length_misaligned();
+    TESTCASE_create_process_grid();
+    TESTCASE_balance_cuts();
+    TESTCASE_hash_population();
+    TESTCASE_find_cycle();
+    TESTCASE_random_population();
+    TESTCASE_pack_pbm_row();
+    TESTCASE_format_pbm_row();
+    TESTCASE_get_owned_pbm_bytes();
+    TESTCASE_format_snapshot_header();
+    TESTCASE_parse_checkpoint_header();
+    TESTCASE_parse_input_header();
+    TESTCASE_decode_rle();
+    TESTCASE_pack_population_roundtrip();
+    TESTCASE_update_population_rows();
+    TESTCASE_update_row_kernels();
+    TESTCASE_update_packed_kernels();
+    TESTCASE_update_uncounted_row_kernels();
+    TESTCASE_update_population_tiles();
+    TESTCASE_track_tile_activity();
+    TESTCASE_parse_rule();
 
     printf("All tests passed!\n");
 
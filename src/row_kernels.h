@@ -0,0 +1,553 @@
+#ifndef MPP_AUTOMATON_ROW_KERNELS_H
+#define MPP_AUTOMATON_ROW_KERNELS_H
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef __x86_64__
+#include <immintrin.h>
+#endif
+
+#include "population_utils.h"
+#include "rules.h"
+
+
+/**
+ * Row kernel definition. Row kernel computes next state of cells [begin, end) in row i, stores them in buffer and adds
+ * the number of live cells and the number of cells that changed state to the counters. Every kernel is specialized for
+ * a single rule at compile time.
+ */
+typedef void (*row_kernel)(
+        cell *mat,
+        cell *buf,
+        unsigned int i,
+        unsigned int begin,
+        unsigned int end,
+        unsigned int width,
+        unsigned long long *cells_alive,
+        unsigned long long *cells_delta
+);
+
+
+/**
+ * Scalar row kernel template. Serves as a fallback on processors without vector extensions and handles row tails of
+ * vectorized kernels.
+ *
+ * @param mat           1D representation of an augmented population of cells.
+ * @param buf           1D buffer that will contain augmented population at next time step.
+ * @param i             Row index.
+ * @param begin         First column.
+ * @param end           Column past the last one.
+ * @param width         Width of the augmented population.
+ * @param cells_alive   Live cell counter.
+ * @param cells_delta   Changed cell counter.
+ * @param rule          Rule bitmask, compile-time constant.
+ * @param count         If false, counters are left untouched, compile-time constant.
+ */
+static ALWAYS_INLINE void update_row_scalar_template(
+        cell *mat,
+        cell *buf,
+        unsigned int i,
+        unsigned int begin,
+        unsigned int end,
+        unsigned int width,
+        unsigned long long *cells_alive,
+        unsigned long long *cells_delta,
+        unsigned int rule,
+        bool count
+) {
+    unsigned long long delta = 0, alive = 0;
+    cell next_state;
+
+    for (unsigned int j = begin; j < end; j++) {
+        next_state = apply_rule(rule, mpp_compute_state_sum(mat, i, j, width));
+
+        if (count) {
+            alive += next_state;
+            delta += buf[i * width + j] != next_state;
+        }
+
+        buf[i * width + j] = next_state;
+    }
+
+    if (count) {
+        *cells_alive += alive;
+        *cells_delta += delta;
+    }
+}
+
+#ifdef __x86_64__
+
+/**
+ * AVX2 row kernel template. Processes 32 cells per iteration. Next state is looked up from the state sum with a byte
+ * shuffle, live cells are counted with SAD and changed cells with popcount of the comparison mask.
+ *
+ * @param mat           1D representation of an augmented population of cells.
+ * @param buf           1D buffer that will contain augmented population at next time step.
+ * @param i             Row index.
+ * @param begin         First column.
+ * @param end           Column past the last one.
+ * @param width         Width of the augmented population.
+ * @param cells_alive   Live cell counter.
+ * @param cells_delta   Changed cell counter.
+ * @param rule          Rule bitmask, compile-time constant.
+ * @param count         If false, counters are left untouched, compile-time constant.
+ */
+__attribute__((target("avx2,popcnt")))
+static ALWAYS_INLINE void update_row_avx2_template(
+        cell *mat,
+        cell *buf,
+        unsigned int i,
+        unsigned int begin,
+        unsigned int end,
+        unsigned int width,
+        unsigned long long *cells_alive,
+        unsigned long long *cells_delta,
+        unsigned int rule,
+        bool count
+) {
+    const __m256i lut = _mm256_setr_epi8(
+            apply_rule(rule, 0), apply_rule(rule, 1), apply_rule(rule, 2), apply_rule(rule, 3),
+            apply_rule(rule, 4), apply_rule(rule, 5), 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+            apply_rule(rule, 0), apply_rule(rule, 1), apply_rule(rule, 2), apply_rule(rule, 3),
+            apply_rule(rule, 4), apply_rule(rule, 5), 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
+    );
+    const __m256i zero = _mm256_setzero_si256();
+
+    unsigned long long delta = 0;
+    __m256i alive = zero, sum, next_state;
+
+    cell *up = &mat[(i - 1) * width];
+    cell *row = &mat[i * width];
+    cell *down = &mat[(i + 1) * width];
+    cell *out = &buf[i * width];
+    unsigned int j = begin;
+
+    for (; j + 32 <= end; j += 32) {
+        sum = _mm256_loadu_si256((__m256i *) &row[j]);
+        sum = _mm256_add_epi8(sum, _mm256_loadu_si256((__m256i *) &row[j - 1]));
+        sum = _mm256_add_epi8(sum, _mm256_loadu_si256((__m256i *) &row[j + 1]));
+        sum = _mm256_add_epi8(sum, _mm256_loadu_si256((__m256i *) &up[j]));
+        sum = _mm256_add_epi8(sum, _mm256_loadu_si256((__m256i *) &down[j]));
+
+        next_state = _mm256_shuffle_epi8(lut, sum);
+
+        if (count) {
+            delta += __builtin_popcount(
+                    ~(unsigned int) _mm256_movemask_epi8(
+                            _mm256_cmpeq_epi8(next_state, _mm256_loadu_si256((__m256i *) &out[j]))));
+            alive = _mm256_add_epi64(alive, _mm256_sad_epu8(next_state, zero));
+        }
+
+        _mm256_storeu_si256((__m256i *) &out[j], next_state);
+    }
+
+    if (count) {
+        *cells_alive += _mm256_extract_epi64(alive, 0) + _mm256_extract_epi64(alive, 1) +
+                        _mm256_extract_epi64(alive, 2) + _mm256_extract_epi64(alive, 3);
+        *cells_delta += delta;
+    }
+
+    update_row_scalar_template(mat, buf, i, j, end, width, cells_alive, cells_delta, rule, count);
+}
+
+/**
+ * AVX-512 row kernel template. Processes 64 cells per iteration, otherwise identical to the AVX2 kernel.
+ *
+ * @param mat           1D representation of an augmented population of cells.
+ * @param buf           1D buffer that will contain augmented population at next time step.
+ * @param i             Row index.
+ * @param begin         First column.
+ * @param end           Column past the last one.
+ * @param width         Width of the augmented population.
+ * @param cells_alive   Live cell counter.
+ * @param cells_delta   Changed cell counter.
+ * @param rule          Rule bitmask, compile-time constant.
+ * @param count         If false, counters are left untouched, compile-time constant.
+ */
+__attribute__((target("avx512f,avx512bw,avx2,popcnt")))
+static ALWAYS_INLINE void update_row_avx512_template(
+        cell *mat,
+        cell *buf,
+        unsigned int i,
+        unsigned int begin,
+        unsigned int end,
+        unsigned int width,
+        unsigned long long *cells_alive,
+        unsigned long long *cells_delta,
+        unsigned int rule,
+        bool count
+) {
+    const __m512i lut = _mm512_broadcast_i32x4(
+            _mm_setr_epi8(
+                    apply_rule(rule, 0), apply_rule(rule, 1), apply_rule(rule, 2), apply_rule(rule, 3),
+                    apply_rule(rule, 4), apply_rule(rule, 5), 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
+            )
+    );
+    const __m512i zero = _mm512_setzero_si512();
+
+    unsigned long long delta = 0;
+    __m512i alive = zero, sum, next_state;
+
+    cell *up = &mat[(i - 1) * width];
+    cell *row = &mat[i * width];
+    cell *down = &mat[(i + 1) * width];
+    cell *out = &buf[i * width];
+    unsigned int j = begin;
+
+    for (; j + 64 <= end; j += 64) {
+        sum = _mm512_loadu_si512(&row[j]);
+        sum = _mm512_add_epi8(sum, _mm512_loadu_si512(&row[j - 1]));
+        sum = _mm512_add_epi8(sum, _mm512_loadu_si512(&row[j + 1]));
+        sum = _mm512_add_epi8(sum, _mm512_loadu_si512(&up[j]));
+        sum = _mm512_add_epi8(sum, _mm512_loadu_si512(&down[j]));
+
+        next_state = _mm512_shuffle_epi8(lut, sum);
+
+        if (count) {
+            delta += __builtin_popcountll(~_mm512_cmpeq_epi8_mask(next_state, _mm512_loadu_si512(&out[j])));
+            alive = _mm512_add_epi64(alive, _mm512_sad_epu8(next_state, zero));
+        }
+
+        _mm512_storeu_si512(&out[j], next_state);
+    }
+
+    if (count) {
+        *cells_alive += _mm512_reduce_add_epi64(alive);
+        *cells_delta += delta;
+    }
+
+    update_row_avx2_template(mat, buf, i, j, end, width, cells_alive, cells_delta, rule, count);
+}
+
+#endif
+
+/**
+ * Generates row kernels specialized for a single rule, and their uncounted variants that skip counting live and
+ * changed cells.
+ */
+#define ROW_KERNEL_PARAMS \
+        cell *mat, cell *buf, unsigned int i, unsigned int begin, unsigned int end, unsigned int width, \
+        unsigned long long *cells_alive, unsigned long long *cells_delta
+#define ROW_KERNEL_ARGS mat, buf, i, begin, end, width, cells_alive, cells_delta
+
+#define DEFINE_SCALAR_ROW_KERNEL(RULE) \
+    void update_row_scalar_##RULE(ROW_KERNEL_PARAMS) { \
+        update_row_scalar_template(ROW_KERNEL_ARGS, RULE, true); \
+    } \
+    void update_row_scalar_uncounted_##RULE(ROW_KERNEL_PARAMS) { \
+        update_row_scalar_template(ROW_KERNEL_ARGS, RULE, false); \
+    }
+#define DEFINE_AVX2_ROW_KERNEL(RULE) \
+    __attribute__((target("avx2,popcnt"))) void update_row_avx2_##RULE(ROW_KERNEL_PARAMS) { \
+        update_row_avx2_template(ROW_KERNEL_ARGS, RULE, true); \
+    } \
+    __attribute__((target("avx2,popcnt"))) void update_row_avx2_uncounted_##RULE(ROW_KERNEL_PARAMS) { \
+        update_row_avx2_template(ROW_KERNEL_ARGS, RULE, false); \
+    }
+#define DEFINE_AVX512_ROW_KERNEL(RULE) \
+    __attribute__((target("avx512f,avx512bw,avx2,popcnt"))) void update_row_avx512_##RULE(ROW_KERNEL_PARAMS) { \
+        update_row_avx512_template(ROW_KERNEL_ARGS, RULE, true); \
+    } \
+    __attribute__((target("avx512f,avx512bw,avx2,popcnt"))) void update_row_avx512_uncounted_##RULE( \
+            ROW_KERNEL_PARAMS) { \
+        update_row_avx512_template(ROW_KERNEL_ARGS, RULE, false); \
+    }
+
+#define SCALAR_ROW_KERNEL_ENTRY(RULE) &update_row_scalar_##RULE,
+#define AVX2_ROW_KERNEL_ENTRY(RULE) &update_row_avx2_##RULE,
+#define AVX512_ROW_KERNEL_ENTRY(RULE) &update_row_avx512_##RULE,
+
+#define SCALAR_UNCOUNTED_ROW_KERNEL_ENTRY(RULE) &update_row_scalar_uncounted_##RULE,
+#define AVX2_UNCOUNTED_ROW_KERNEL_ENTRY(RULE) &update_row_avx2_uncounted_##RULE,
+#define AVX512_UNCOUNTED_ROW_KERNEL_ENTRY(RULE) &update_row_avx512_uncounted_##RULE,
+
+FOR_EACH_RULE(DEFINE_SCALAR_ROW_KERNEL)
+
+const row_kernel scalar_row_kernels[RULE_COUNT] = {FOR_EACH_RULE(SCALAR_ROW_KERNEL_ENTRY)};
+const row_kernel scalar_uncounted_row_kernels[RULE_COUNT] = {FOR_EACH_RULE(SCALAR_UNCOUNTED_ROW_KERNEL_ENTRY)};
+
+#ifdef __x86_64__
+
+FOR_EACH_RULE(DEFINE_AVX2_ROW_KERNEL)
+FOR_EACH_RULE(DEFINE_AVX512_ROW_KERNEL)
+
+const row_kernel avx2_row_kernels[RULE_COUNT] = {FOR_EACH_RULE(AVX2_ROW_KERNEL_ENTRY)};
+const row_kernel avx512_row_kernels[RULE_COUNT] = {FOR_EACH_RULE(AVX512_ROW_KERNEL_ENTRY)};
+
+const row_kernel avx2_uncounted_row_kernels[RULE_COUNT] = {FOR_EACH_RULE(AVX2_UNCOUNTED_ROW_KERNEL_ENTRY)};
+const row_kernel avx512_uncounted_row_kernels[RULE_COUNT] = {FOR_EACH_RULE(AVX512_UNCOUNTED_ROW_KERNEL_ENTRY)};
+
+#endif
+
+/**
+ * Checks whether kernel belongs to a kernel table.
+ *
+ * @param kernels   Kernel table.
+ * @param kernel    Row kernel.
+ * @return          True if kernel is in the table, otherwise false.
+ */
+static inline bool contains_row_kernel(const row_kernel *kernels, row_kernel kernel) {
+    for (unsigned int rule = 0; rule < RULE_COUNT; rule++) {
+        if (kernels[rule] == kernel) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * Selects the fastest row kernel supported by the processor for a given rule.
+ *
+ * @param rule  Rule bitmask.
+ * @param count If false, selects a kernel that doesn't count live and changed cells.
+ * @return      Row kernel.
+ */
+row_kernel select_row_kernel_variant(unsigned int rule, bool count) {
+#ifdef __x86_64__
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")) {
+        return count ? avx512_row_kernels[rule] : avx512_uncounted_row_kernels[rule];
+    }
+
+    if (__builtin_cpu_supports("avx2")) {
+        return count ? avx2_row_kernels[rule] : avx2_uncounted_row_kernels[rule];
+    }
+#endif
+
+    return count ? scalar_row_kernels[rule] : scalar_uncounted_row_kernels[rule];
+}
+
+/**
+ * Selects the fastest row kernel supported by the processor for a given rule.
+ *
+ * @param rule  Rule bitmask.
+ * @return      Row kernel.
+ */
+row_kernel select_row_kernel(unsigned int rule) {
+    return select_row_kernel_variant(rule, true);
+}
+
+/**
+ * Returns human readable name of a row kernel.
+ *
+ * @param kernel    Row kernel.
+ * @return          Kernel name.
+ */
+const char *get_row_kernel_name(row_kernel kernel) {
+#ifdef __x86_64__
+    if (contains_row_kernel(avx512_row_kernels, kernel)) {
+        return "avx512";
+    }
+
+    if (contains_row_kernel(avx2_row_kernels, kernel)) {
+        return "avx2";
+    }
+#endif
+
+    return "scalar";
+}
+
+/**
+ * Computes state of the simulation at next time step using augmented population of cells and a row kernel. Produces
+ * the same population and stats as update_population with an equivalent rule.
+ *
+ * @param mat               1D representation of an augmented population of cells.
+ * @param buf               1D buffer that will contain augmented population at next time step.
+ * @param cells_alive       Number of live cells at next time step.
+ * @param cells_delta       Number of cells that changed state.
+ * @param height            Height of the augmented population.
+ * @param width             Width of the augmented population.
+ * @param update_row_fn_ptr Row kernel.
+ */
+void update_population_rows(
+        cell *mat,
+        cell *buf,
+        unsigned long long *cells_alive,
+        unsigned long long *cells_delta,
+        unsigned int height,
+        unsigned int width,
+        row_kernel update_row_fn_ptr
+) {
+    unsigned long long delta = 0, alive = 0;
+
+#pragma omp parallel for schedule(static) reduction(+:alive, delta)
+    for (unsigned int i = 1; i < height - 1; i++) {
+        update_row_fn_ptr(mat, buf, i, 1, width - 1, width, &alive, &delta);
+    }
+
+    *cells_alive = alive;
+    *cells_delta = delta;
+}
+
+
+/**
+ * Computes next state of cells [left, right) in row i of an augmented population with deep halos. Only interior cells,
+ * i.e. cells at least halo cells away from the population boundary, contribute to the stats.
+ *
+ * @param mat               1D representation of an augmented population of cells.
+ * @param buf               1D buffer that will contain augmented population at next time step.
+ * @param i                 Row index.
+ * @param left              First column.
+ * @param right             Column past the last column.
+ * @param height            Height of the augmented population.
+ * @param width             Width of the augmented population.
+ * @param halo              Halo depth.
+ * @param cells_alive       Live interior cell counter.
+ * @param cells_delta       Changed interior cell counter.
+ * @param update_row_fn_ptr Row kernel.
+ */
+static inline void update_region_row(
+        cell *mat,
+        cell *buf,
+        unsigned int i,
+        unsigned int left,
+        unsigned int right,
+        unsigned int height,
+        unsigned int width,
+        unsigned int halo,
+        unsigned long long *cells_alive,
+        unsigned long long *cells_delta,
+        row_kernel update_row_fn_ptr
+) {
+    unsigned long long redundant_delta = 0, redundant_alive = 0;
+    unsigned int begin = left > halo ? left : halo;
+    unsigned int end = right < width - halo ? right : width - halo;
+
+    if (i < halo || i >= height - halo || begin >= end) {
+        update_row_fn_ptr(mat, buf, i, left, right, width, &redundant_alive, &redundant_delta);
+        return;
+    }
+
+    if (left < begin) {
+        update_row_fn_ptr(mat, buf, i, left, begin, width, &redundant_alive, &redundant_delta);
+    }
+
+    update_row_fn_ptr(mat, buf, i, begin, end, width, cells_alive, cells_delta);
+
+    if (end < right) {
+        update_row_fn_ptr(mat, buf, i, end, right, width, &redundant_alive, &redundant_delta);
+    }
+}
+
+
+/**
+ * Computes next state of cells in region [top, bottom) x [left, right) of an augmented population with deep halos.
+ * Region may extend into the halo, in which case halo cells are recomputed redundantly. Only interior cells, i.e. cells
+ * at least halo cells away from the population boundary, contribute to the stats.
+ *
+ * @param mat               1D representation of an augmented population of cells.
+ * @param buf               1D buffer that will contain augmented population at next time step.
+ * @param cells_alive       Number of live interior cells at next time step.
+ * @param cells_delta       Number of interior cells that changed state.
+ * @param height            Height of the augmented population.
+ * @param width             Width of the augmented population.
+ * @param halo              Halo depth.
+ * @param top               First row of the region.
+ * @param bottom            Row past the last row of the region.
+ * @param left              First column of the region.
+ * @param right             Column past the last column of the region.
+ * @param update_row_fn_ptr Row kernel.
+ */
+void update_population_region(
+        cell *mat,
+        cell *buf,
+        unsigned long long *cells_alive,
+        unsigned long long *cells_delta,
+        unsigned int height,
+        unsigned int width,
+        unsigned int halo,
+        unsigned int top,
+        unsigned int bottom,
+        unsigned int left,
+        unsigned int right,
+        row_kernel update_row_fn_ptr
+) {
+    unsigned long long delta = 0, alive = 0;
+
+#pragma omp parallel for schedule(static) reduction(+:alive, delta)
+    for (unsigned int i = top; i < bottom; i++) {
+        update_region_row(mat, buf, i, left, right, height, width, halo, &alive, &delta, update_row_fn_ptr);
+    }
+
+    *cells_alive = alive;
+    *cells_delta = delta;
+}
+
+/**
+ * Computes next state of cells that don't depend on halos, i.e. all cells except the one-cell boundary ring.
+ *
+ * @param mat               1D representation of an augmented population of cells.
+ * @param buf               1D buffer that will contain augmented population at next time step.
+ * @param cells_alive       Number of live cells at next time step.
+ * @param cells_delta       Number of cells that changed state.
+ * @param height            Height of the augmented population.
+ * @param width             Width of the augmented population.
+ * @param update_row_fn_ptr Row kernel.
+ */
+void update_population_interior(
+        cell *mat,
+        cell *buf,
+        unsigned long long *cells_alive,
+        unsigned long long *cells_delta,
+        unsigned int height,
+        unsigned int width,
+        row_kernel update_row_fn_ptr
+) {
+    unsigned long long delta = 0, alive = 0;
+
+#pragma omp parallel for schedule(static) reduction(+:alive, delta)
+    for (unsigned int i = 2; i < height - 2; i++) {
+        update_row_fn_ptr(mat, buf, i, 2, width - 2, width, &alive, &delta);
+    }
+
+    *cells_alive = alive;
+    *cells_delta = delta;
+}
+
+/**
+ * Computes next state of the one-cell boundary ring, i.e. cells that depend on halos.
+ *
+ * @param mat               1D representation of an augmented population of cells.
+ * @param buf               1D buffer that will contain augmented population at next time step.
+ * @param cells_alive       Number of live cells at next time step.
+ * @param cells_delta       Number of cells that changed state.
+ * @param height            Height of the augmented population.
+ * @param width             Width of the augmented population.
+ * @param update_row_fn_ptr Row kernel.
+ */
+void update_population_ring(
+        cell *mat,
+        cell *buf,
+        unsigned long long *cells_alive,
+        unsigned long long *cells_delta,
+        unsigned int height,
+        unsigned int width,
+        row_kernel update_row_fn_ptr
+) {
+    unsigned long long delta = 0, alive = 0;
+
+    // First and last rows.
+    update_row_fn_ptr(mat, buf, 1, 1, width - 1, width, &alive, &delta);
+
+    if (height > 3) {
+        update_row_fn_ptr(mat, buf, height - 2, 1, width - 1, width, &alive, &delta);
+    }
+
+    // First and last columns.
+#pragma omp parallel for schedule(static) reduction(+:alive, delta) if (height >= PARALLEL_HALO_LEN)
+    for (unsigned int i = 2; i < height - 2; i++) {
+        update_row_fn_ptr(mat, buf, i, 1, 2, width, &alive, &delta);
+
+        if (width > 3) {
+            update_row_fn_ptr(mat, buf, i, width - 2, width - 1, width, &alive, &delta);
+        }
+    }
+
+    *cells_alive = alive;
+    *cells_delta = delta;
+}
+
+#endif //MPP_AUTOMATON_ROW_KERNELS_H
@@ -0,0 +1,102 @@
+#ifndef MPP_AUTOMATON_RULES_H
+#define MPP_AUTOMATON_RULES_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include "population_utils.h"
+
+
+/**
+ * Rule definition. Rule is a bitmask over state sums, i.e. cell is alive at next time step if bit number `sum` of the
+ * rule is set. State sum of the 5-point neighbourhood lies in [0, 5], hence there are 64 distinct rules.
+ */
+#define MAX_STATE_SUM 5
+#define RULE_COUNT 64
+#define MPP_RULE 52     // Sums 2, 4 and 5.
+
+
+/**
+ * Forces inlining of kernel templates, so that the rule passed as a compile-time constant is folded away.
+ */
+#define ALWAYS_INLINE inline __attribute__((always_inline))
+
+
+/**
+ * Expands X for every rule. Used to generate kernels specialized at compile time for each rule.
+ */
+#define FOR_EACH_RULE(X) \
+        X(0) X(1) X(2) X(3) X(4) X(5) X(6) X(7) \
+        X(8) X(9) X(10) X(11) X(12) X(13) X(14) X(15) \
+        X(16) X(17) X(18) X(19) X(20) X(21) X(22) X(23) \
+        X(24) X(25) X(26) X(27) X(28) X(29) X(30) X(31) \
+        X(32) X(33) X(34) X(35) X(36) X(37) X(38) X(39) \
+        X(40) X(41) X(42) X(43) X(44) X(45) X(46) X(47) \
+        X(48) X(49) X(50) X(51) X(52) X(53) X(54) X(55) \
+        X(56) X(57) X(58) X(59) X(60) X(61) X(62) X(63)
+
+
+/**
+ * Returns cell's next state given the state sum and rule.
+ *
+ * @param rule  Rule bitmask.
+ * @param sum   Sum of cell's value and its nearest neighbours.
+ * @return      Next state.
+ */
+static inline cell apply_rule(unsigned int rule, cell sum) {
+    return (rule >> sum) & 1;
+}
+
+/**
+ * Parses comma-separated list of state sums that give a live cell, e.g. "2,4,5".
+ *
+ * @param arg   String to parse.
+ * @param rule  Parsed rule bitmask.
+ * @return      True if the string is a valid rule, otherwise false.
+ */
+bool parse_rule(const char *arg, unsigned int *rule) {
+    unsigned int mask = 0;
+    char *end;
+    long sum;
+
+    do {
+        sum = strtol(arg, &end, 10);
+
+        if (end == arg || sum < 0 || sum > MAX_STATE_SUM) {
+            return false;
+        }
+
+        mask |= 1u << sum;
+        arg = end + 1;
+    } while (*end == ',');
+
+    if (*end != '\0') {
+        return false;
+    }
+
+    *rule = mask;
+
+    return true;
+}
+
+/**
+ * Formats rule as comma-separated list of state sums.
+ *
+ * @param rule  Rule bitmask.
+ * @param buf   Target buffer, at least 2 * (MAX_STATE_SUM + 1) characters long.
+ */
+void format_rule(unsigned int rule, char *buf) {
+    char *cursor = buf;
+
+    for (int sum = 0; sum <= MAX_STATE_SUM; sum++) {
+        if (rule & (1u << sum)) {
+            cursor += sprintf(cursor, (cursor == buf) ? "%d" : ",%d", sum);
+        }
+    }
+
+    *cursor = '\0';
+}
+
+
+#endif //MPP_AUTOMATON_RULES_H
@@ -2,3 +2,12 @@
 
 mpirun -n 1 ./population_utils_test
 mpirun -n 9 ./halo_swap_test -l 30 0
+mpirun -n 9 ./halo_swap_test -l 30 -k 3 0
+mpirun -n 9 ./halo_swap_test -l 30 -x datatype 0
+mpirun -n 9 ./halo_swap_test -l 30 -k 3 -x datatype 0
+mpirun -n 9 ./halo_swap_test -l 30 -x neighbour 0
+mpirun -n 9 ./halo_swap_test -l 30 -k 3 -x neighbour 0
+mpirun -n 9 ./halo_swap_test -l 31 -x shared 0
+mpirun -n 9 ./halo_swap_test -l 31 -x rma 0
+diff <(mpirun -n 4 ./automaton -l 60 -m 12 -e 0 -w 0 -C 2 7 | grep checksum) \
+     <(mpirun -n 4 ./automaton -l 60 -m 12 -e 0 -w 0 -C 2 -t 16 -k 3 7 | grep checksum) && echo "All tests passed!"
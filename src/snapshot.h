@@ -0,0 +1,240 @@
+#ifndef MPP_AUTOMATON_SNAPSHOT_H
+#define MPP_AUTOMATON_SNAPSHOT_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <mpi.h>
+
+#include "automaton.h"
+#include "checkpoint.h"
+#include "io.h"
+
+
+/**
+ * Number of frames that may be written at once. Once all are in flight, the next frame waits for the oldest one.
+ */
+#define SNAPSHOT_SLOTS 2
+
+#define SNAPSHOT_FILENAME "frames.pbm"
+
+/**
+ * Length of the header of every frame. Headers are padded to it, so that every frame takes the same number of bytes.
+ */
+#define SNAPSHOT_HEADER_LEN 64
+
+
+/**
+ * Frame being written, with the staging buffer and header that must outlive the write.
+ */
+typedef struct {
+    MPI_Request requests[2];
+    unsigned char *buf;
+    char header[SNAPSHOT_HEADER_LEN];
+    bool pending;
+} SnapshotSlot;
+
+struct SnapshotQueue {
+    SnapshotSlot slots[SNAPSHOT_SLOTS];
+    unsigned int next;
+
+    MPI_File file;
+    MPI_File header_file;
+    MPI_Datatype row_type;
+    MPI_Offset frame_size;
+};
+
+
+/**
+ * Formats header of a frame, padded with spaces within a comment to exactly SNAPSHOT_HEADER_LEN bytes.
+ *
+ * @param header    Target buffer of SNAPSHOT_HEADER_LEN bytes, not null-terminated.
+ * @param width     Width of the global population.
+ * @param height    Height of the global population.
+ * @param step      Step of the frame.
+ */
+void format_snapshot_header(char *header, int width, int height, unsigned int step) {
+    char size[SNAPSHOT_HEADER_LEN];
+
+    int size_len = snprintf(size, SNAPSHOT_HEADER_LEN, "\n%d %d\n", width, height);
+    int len = snprintf(header, SNAPSHOT_HEADER_LEN, "P4\n# step %u", step);
+
+    memset(header + len, ' ', SNAPSHOT_HEADER_LEN - len - size_len);
+    memcpy(header + SNAPSHOT_HEADER_LEN - size_len, size, size_len);
+}
+
+/**
+ * Waits for a frame to be written. Waiting is local, so processes may finish slots whenever their writes complete.
+ *
+ * @param slot  Snapshot slot.
+ */
+void finish_snapshot(SnapshotSlot *slot) {
+    if (!slot->pending) {
+        return;
+    }
+
+    MPI_Waitall(2, slot->requests, MPI_STATUSES_IGNORE);
+
+    slot->pending = false;
+}
+
+/**
+ * Places the pixels of this process within every frame of the frames file. The file type selects owned bytes of an
+ * image and is resized to the length of a frame, so that frames tile the file and the view only changes along with
+ * partitions. Must be called by all processes, and waits for frames in flight first.
+ *
+ * @param sim   Simulation data.
+ * @param queue SnapshotQueue struct.
+ */
+void set_snapshot_view(SimulationData *sim, SnapshotQueue *queue) {
+    MPI_Datatype file_type = MPI_BYTE, image_type;
+    unsigned int first_byte, n_bytes;
+
+    for (unsigned int i = 0; i < SNAPSHOT_SLOTS; i++) {
+        finish_snapshot(&queue->slots[i]);
+    }
+
+    get_owned_pbm_bytes(sim, &first_byte, &n_bytes);
+
+    if (n_bytes > 0) {
+        image_type = create_pbm_file_type(sim, first_byte, n_bytes);
+
+        MPI_Type_create_resized(image_type, 0, queue->frame_size, &file_type);
+        MPI_Type_commit(&file_type);
+        MPI_Type_free(&image_type);
+    }
+
+    MPI_File_set_view(queue->file, SNAPSHOT_HEADER_LEN, MPI_BYTE, file_type, "native", MPI_INFO_NULL);
+
+    if (file_type != MPI_BYTE) {
+        MPI_Type_free(&file_type);
+    }
+
+    if (queue->row_type != MPI_DATATYPE_NULL) {
+        MPI_Type_free(&queue->row_type);
+    }
+
+    queue->row_type = create_pbm_row_type(n_bytes);
+}
+
+/**
+ * Initializes an empty snapshot queue and opens the frames file. Frame of step S is placed S / frame interval frames
+ * into the file, which is truncated to the frames before the start step, so a restarted run continues the frames of the
+ * run it restarts. The controller also opens the file on its own, to write headers without other processes.
+ *
+ * @param sim   Simulation data.
+ * @param queue SnapshotQueue struct.
+ */
+void init_snapshot_queue(SimulationData *sim, SnapshotQueue *queue) {
+    unsigned int interval = sim->args->frame_interval;
+
+    for (unsigned int i = 0; i < SNAPSHOT_SLOTS; i++) {
+        queue->slots[i].requests[0] = queue->slots[i].requests[1] = MPI_REQUEST_NULL;
+        queue->slots[i].buf = NULL;
+        queue->slots[i].pending = false;
+    }
+
+    queue->next = 0;
+    queue->header_file = MPI_FILE_NULL;
+    queue->row_type = MPI_DATATYPE_NULL;
+    queue->frame_size = SNAPSHOT_HEADER_LEN + get_pbm_image_size(sim);
+
+    MPI_File_open(sim->comm, SNAPSHOT_FILENAME, MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL, &queue->file);
+    MPI_File_set_size(queue->file, (MPI_Offset) ((sim->start_step + interval - 1) / interval) * queue->frame_size);
+
+    if (sim->rank == CONTROLLER_RANK) {
+        MPI_File_open(MPI_COMM_SELF, SNAPSHOT_FILENAME, MPI_MODE_WRONLY, MPI_INFO_NULL, &queue->header_file);
+    }
+
+    set_snapshot_view(sim, queue);
+}
+
+/**
+ * Progresses frames in flight without waiting for them, since writes may only advance within MPI calls.
+ *
+ * @param queue SnapshotQueue struct.
+ */
+void progress_snapshots(SnapshotQueue *queue) {
+    int flag;
+
+    for (unsigned int i = 0; i < SNAPSHOT_SLOTS; i++) {
+        if (queue->slots[i].pending) {
+            MPI_Testall(2, queue->slots[i].requests, &flag, MPI_STATUSES_IGNORE);
+        }
+    }
+}
+
+/**
+ * Starts writing a generation to its frame in the frames file. Pixels are packed into the staging buffer of the next
+ * slot and written with a non-blocking collective write at the offset of the frame, and the controller writes the
+ * header with a non-blocking write of its own, so stepping continues while the frame is written. Only if the slot still
+ * holds a frame in flight does the step loop wait for it.
+ *
+ * @param sim           Simulation data.
+ * @param generation    Local generation of cells.
+ * @param step          Step of the generation.
+ */
+void write_snapshot(SimulationData *sim, void *generation, unsigned int step) {
+    SnapshotQueue *queue = sim->snapshot_queue;
+    SnapshotSlot *slot = &queue->slots[queue->next];
+
+    queue->next = (queue->next + 1) % SNAPSHOT_SLOTS;
+
+    finish_snapshot(slot);
+
+    unsigned int halo, first_byte, n_bytes;
+    MPI_Offset frame = step / sim->args->frame_interval;
+
+    get_owned_pbm_bytes(sim, &first_byte, &n_bytes);
+
+    // Partitions move when rebalanced, so the staging buffer is resized for every frame.
+    size_t count = (size_t) sim->local_height * n_bytes;
+    slot->buf = realloc(slot->buf, count > 0 ? count : 1);
+
+    cell *population = get_generation_cells(sim, generation, &halo);
+    MPI_Datatype file_type = pack_global_pbm_pixels(sim, population, halo, slot->buf);
+    free_generation_cells(sim, population);
+
+    // Pixels are placed by the view of the frames file instead.
+    if (file_type != MPI_BYTE) {
+        MPI_Type_free(&file_type);
+    }
+
+    if (sim->rank == CONTROLLER_RANK) {
+        format_snapshot_header(slot->header, sim->args->width, sim->args->height, step);
+        MPI_File_iwrite_at(queue->header_file, frame * queue->frame_size, slot->header, SNAPSHOT_HEADER_LEN, MPI_CHAR,
+                           &slot->requests[1]);
+    }
+
+    // Offsets within the view only count bytes owned by this process.
+    MPI_File_iwrite_at_all(queue->file, frame * (MPI_Offset) count, slot->buf, (int) sim->local_height,
+                           queue->row_type, &slot->requests[0]);
+
+    slot->pending = true;
+}
+
+/**
+ * Finishes all frames in flight, closes the frames file and frees staging buffers. Must be called by all processes
+ * before MPI_Finalize.
+ *
+ * @param queue SnapshotQueue struct.
+ */
+void free_snapshot_queue(SnapshotQueue *queue) {
+    for (unsigned int i = 0; i < SNAPSHOT_SLOTS; i++) {
+        finish_snapshot(&queue->slots[i]);
+        free(queue->slots[i].buf);
+
+        queue->slots[i].buf = NULL;
+    }
+
+    if (queue->header_file != MPI_FILE_NULL) {
+        MPI_File_close(&queue->header_file);
+    }
+
+    MPI_File_close(&queue->file);
+    MPI_Type_free(&queue->row_type);
+}
+
+
+#endif //MPP_AUTOMATON_SNAPSHOT_H
@@ -0,0 +1,374 @@
+#ifndef MPP_AUTOMATON_TILED_POPULATION_H
+#define MPP_AUTOMATON_TILED_POPULATION_H
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "population_utils.h"
+#include "row_kernels.h"
+
+
+/**
+ * Region of the augmented population computed at a single step, and the row kernel used to compute it.
+ */
+typedef struct {
+    unsigned int top;
+    unsigned int bottom;
+    unsigned int left;
+    unsigned int right;
+
+    row_kernel update_row_fn_ptr;
+} StepRegion;
+
+
+/**
+ * Number of initial steps at which all tiles are computed, until both generation buffers hold computed generations.
+ */
+#define ACTIVITY_WARMUP_STEPS 2
+
+
+/**
+ * Container for tiles of the augmented population. Tiles are square blocks of cells computed by OpenMP tasks. Next
+ * generation of a tile depends only on the tile and its four neighbours in the previous generation, so tasks of
+ * consecutive steps are chained by dependencies on per-tile sentinels instead of a barrier, and idle threads pick up
+ * any tile whose dependencies are met.
+ *
+ * With activity tracking, a tile is only recomputed if it or one of its neighbours changed at the previous step. Since
+ * the row kernels write the next generation over the generation before the current one, a tile that is skipped already
+ * holds its next generation, and its live cell count is the one last recorded for the same buffer. Activity is decided
+ * when tasks are created, so it is only tracked one step at a time.
+ */
+typedef struct {
+    unsigned int tile_size;
+    unsigned int tile_rows;
+    unsigned int tile_cols;
+    unsigned int n_tiles;
+    unsigned int max_steps;
+
+    // Dependency sentinels of tiles stored in the first and second generation buffer.
+    char *generation_deps[2];
+
+    // Stats of every tile at every step of a block.
+    unsigned long long *tile_alive;
+    unsigned long long *tile_delta;
+
+    // Stats of every step of a block, and the number of steps already consumed.
+    unsigned long long *step_alive;
+    unsigned long long *step_delta;
+    unsigned int block_len;
+    unsigned int block_step;
+
+    // Activity of tiles, see above.
+    bool track_activity;
+    unsigned int warmup_steps;
+    unsigned int parity;
+    unsigned char *tile_changed;
+    unsigned long long *buffer_alive[2];
+
+    // Halo ring of the augmented population before the last swap: upper row, lower row, left and right column.
+    cell *halo_ring;
+} TileGrid;
+
+
+/**
+ * Initializes tile grid that covers augmented population.
+ *
+ * @param height            Height of the augmented population.
+ * @param width             Width of the augmented population.
+ * @param tile_size         Side length of a tile.
+ * @param max_steps         Maximum number of steps computed by a single task graph.
+ * @param track_activity    If true, tiles that can't change are skipped. Requires max_steps to be 1.
+ * @return                  Pointer to TileGrid struct.
+ */
+TileGrid *init_tile_grid(unsigned int height, unsigned int width, unsigned int tile_size, unsigned int max_steps,
+                         bool track_activity) {
+    TileGrid *grid = calloc(1, sizeof(TileGrid));
+
+    grid->tile_size = tile_size;
+    grid->tile_rows = (height + tile_size - 1) / tile_size;
+    grid->tile_cols = (width + tile_size - 1) / tile_size;
+    grid->n_tiles = grid->tile_rows * grid->tile_cols;
+    grid->max_steps = max_steps;
+
+    grid->generation_deps[0] = calloc(grid->n_tiles, sizeof(char));
+    grid->generation_deps[1] = calloc(grid->n_tiles, sizeof(char));
+
+    grid->tile_alive = calloc(max_steps * grid->n_tiles, sizeof(unsigned long long));
+    grid->tile_delta = calloc(max_steps * grid->n_tiles, sizeof(unsigned long long));
+
+    grid->step_alive = calloc(max_steps, sizeof(unsigned long long));
+    grid->step_delta = calloc(max_steps, sizeof(unsigned long long));
+
+    grid->block_len = 0;
+    grid->block_step = 0;
+
+    grid->track_activity = track_activity;
+    grid->warmup_steps = ACTIVITY_WARMUP_STEPS;
+    grid->parity = 0;
+
+    if (track_activity) {
+        grid->tile_changed = calloc(grid->n_tiles, sizeof(unsigned char));
+        grid->buffer_alive[0] = calloc(grid->n_tiles, sizeof(unsigned long long));
+        grid->buffer_alive[1] = calloc(grid->n_tiles, sizeof(unsigned long long));
+        grid->halo_ring = calloc(2 * (height + width), sizeof(cell));
+    }
+
+    return grid;
+}
+
+
+/**
+ * Frees tile grid.
+ *
+ * @param grid  TileGrid struct.
+ */
+void free_tile_grid(TileGrid *grid) {
+    free(grid->generation_deps[0]);
+    free(grid->generation_deps[1]);
+
+    free(grid->tile_alive);
+    free(grid->tile_delta);
+
+    free(grid->step_alive);
+    free(grid->step_delta);
+
+    // Free of NULL is a no-op if activity is not tracked.
+    free(grid->tile_changed);
+    free(grid->buffer_alive[0]);
+    free(grid->buffer_alive[1]);
+    free(grid->halo_ring);
+
+    free(grid);
+}
+
+
+/**
+ * Computes next state of cells of a single tile that fall into the region of the step. Behaves like
+ * update_population_region restricted to the tile.
+ *
+ * @param mat           1D representation of an augmented population of cells.
+ * @param buf           1D buffer that will contain augmented population at next time step.
+ * @param cells_alive   Number of live interior cells of the tile at next time step.
+ * @param cells_delta   Number of interior cells of the tile that changed state.
+ * @param height        Height of the augmented population.
+ * @param width         Width of the augmented population.
+ * @param halo          Halo depth.
+ * @param grid          TileGrid struct.
+ * @param tile          Tile index.
+ * @param region        Region computed at this step.
+ */
+void update_tile(
+        cell *mat,
+        cell *buf,
+        unsigned long long *cells_alive,
+        unsigned long long *cells_delta,
+        unsigned int height,
+        unsigned int width,
+        unsigned int halo,
+        TileGrid *grid,
+        unsigned int tile,
+        StepRegion region
+) {
+    unsigned long long delta = 0, alive = 0;
+
+    unsigned int top = (tile / grid->tile_cols) * grid->tile_size;
+    unsigned int left = (tile % grid->tile_cols) * grid->tile_size;
+    unsigned int bottom = top + grid->tile_size;
+    unsigned int right = left + grid->tile_size;
+
+    // Clip tile to the region.
+    top = top > region.top ? top : region.top;
+    left = left > region.left ? left : region.left;
+    bottom = bottom < region.bottom ? bottom : region.bottom;
+    right = right < region.right ? right : region.right;
+
+    if (left < right) {
+        for (unsigned int i = top; i < bottom; i++) {
+            update_region_row(mat, buf, i, left, right, height, width, halo, &alive, &delta,
+                              region.update_row_fn_ptr);
+        }
+    }
+
+    *cells_alive = alive;
+    *cells_delta = delta;
+}
+
+
+/**
+ * Returns tile that contains a cell.
+ *
+ * @param grid  TileGrid struct.
+ * @param i     Row index.
+ * @param j     Column index.
+ * @return      Tile index.
+ */
+static inline unsigned int get_cell_tile(TileGrid *grid, unsigned int i, unsigned int j) {
+    return (i / grid->tile_size) * grid->tile_cols + j / grid->tile_size;
+}
+
+
+/**
+ * Saves halo ring of the augmented population before halos are swapped.
+ *
+ * @param grid      TileGrid struct.
+ * @param mat       Augmented population of cells.
+ * @param height    Height of the augmented population.
+ * @param width     Width of the augmented population.
+ */
+void save_halo_ring(TileGrid *grid, cell *mat, unsigned int height, unsigned int width) {
+    copy_row(mat, grid->halo_ring, width, width, 0, 0);
+    copy_row(mat, grid->halo_ring + width, width, width, height - 1, 0);
+    copy_column(mat, grid->halo_ring + 2 * width, width, height, 0, 0);
+    copy_column(mat, grid->halo_ring + 2 * width + height, width, height, width - 1, 0);
+}
+
+
+/**
+ * Marks tiles whose halo cells differ from the halo ring saved before the swap as changed, so that tiles next to them
+ * are recomputed. Since halos of a generation buffer are swapped every other step, halos are compared with the
+ * generation before the previous one, like cells computed by the row kernels.
+ *
+ * @param grid      TileGrid struct.
+ * @param mat       Augmented population of cells.
+ * @param height    Height of the augmented population.
+ * @param width     Width of the augmented population.
+ */
+void mark_changed_halos(TileGrid *grid, cell *mat, unsigned int height, unsigned int width) {
+    cell *up = grid->halo_ring, *down = up + width, *left = down + width, *right = left + height;
+
+    for (unsigned int j = 0; j < width; j++) {
+        if (mat[j] != up[j]) {
+            grid->tile_changed[get_cell_tile(grid, 0, j)] = 1;
+        }
+
+        if (mat[(height - 1) * width + j] != down[j]) {
+            grid->tile_changed[get_cell_tile(grid, height - 1, j)] = 1;
+        }
+    }
+
+    for (unsigned int i = 0; i < height; i++) {
+        if (mat[i * width] != left[i]) {
+            grid->tile_changed[get_cell_tile(grid, i, 0)] = 1;
+        }
+
+        if (mat[i * width + width - 1] != right[i]) {
+            grid->tile_changed[get_cell_tile(grid, i, width - 1)] = 1;
+        }
+    }
+}
+
+
+/**
+ * Checks whether tile has to be recomputed, i.e. whether it or one of its neighbours changed at the previous step.
+ *
+ * @param grid  TileGrid struct.
+ * @param t     Tile index.
+ * @param up    Upper neighbour.
+ * @param down  Lower neighbour.
+ * @param left  Left neighbour.
+ * @param right Right neighbour.
+ * @return      True if tile is active, otherwise false.
+ */
+static inline bool is_tile_active(TileGrid *grid, unsigned int t, unsigned int up, unsigned int down,
+                                  unsigned int left, unsigned int right) {
+    unsigned char *changed = grid->tile_changed;
+
+    return !grid->track_activity || grid->warmup_steps > 0 ||
+           changed[t] || changed[up] || changed[down] || changed[left] || changed[right];
+}
+
+
+/**
+ * Records activity of tiles after a step. Tile changed if any of its cells differs from the generation it overwrote.
+ *
+ * @param grid  TileGrid struct.
+ */
+void update_tile_activity(TileGrid *grid) {
+    grid->parity ^= 1;
+
+    for (unsigned int t = 0; t < grid->n_tiles; t++) {
+        grid->tile_changed[t] = grid->tile_delta[t] > 0;
+        grid->buffer_alive[grid->parity][t] = grid->tile_alive[t];
+    }
+
+    if (grid->warmup_steps > 0) {
+        grid->warmup_steps--;
+    }
+}
+
+
+/**
+ * Advances augmented population by a block of steps. Every tile of every step is a task that waits only for the tile
+ * and its four neighbours at the previous step, and for readers of the buffer it overwrites, so threads run ahead into
+ * later steps on tiles whose dependencies are done. Generations alternate between the two buffers, starting with
+ * fst_generation. Produces the same populations and stats as calling update_population_region once per step.
+ *
+ * @param grid              TileGrid struct.
+ * @param fst_generation    Current generation of cells.
+ * @param snd_generation    Buffer for the next generation of cells.
+ * @param height            Height of the augmented population.
+ * @param width             Width of the augmented population.
+ * @param halo              Halo depth.
+ * @param regions           Regions computed at each step.
+ * @param steps             Number of steps, at most max_steps of the grid.
+ */
+void update_population_tiles(
+        TileGrid *grid,
+        cell *fst_generation,
+        cell *snd_generation,
+        unsigned int height,
+        unsigned int width,
+        unsigned int halo,
+        const StepRegion *regions,
+        unsigned int steps
+) {
+    unsigned int cols = grid->tile_cols, n_tiles = grid->n_tiles;
+
+#pragma omp parallel
+#pragma omp single
+    for (unsigned int s = 0; s < steps; s++) {
+        cell *mat = (s % 2 == 0) ? fst_generation : snd_generation;
+        cell *buf = (s % 2 == 0) ? snd_generation : fst_generation;
+
+        for (unsigned int t = 0; t < n_tiles; t++) {
+            // Missing neighbours on the edges depend on the tile itself.
+            unsigned int up = (t >= cols) ? t - cols : t;
+            unsigned int down = (t + cols < n_tiles) ? t + cols : t;
+            unsigned int left = (t % cols > 0) ? t - 1 : t;
+            unsigned int right = (t % cols + 1 < cols) ? t + 1 : t;
+
+            // Tile already holds its next generation.
+            if (!is_tile_active(grid, t, up, down, left, right)) {
+                grid->tile_alive[s * n_tiles + t] = grid->buffer_alive[grid->parity ^ 1][t];
+                grid->tile_delta[s * n_tiles + t] = 0;
+                continue;
+            }
+
+#pragma omp task firstprivate(mat, buf, s, t) \
+        depend(in: grid->generation_deps[s % 2][t], grid->generation_deps[s % 2][up], \
+                   grid->generation_deps[s % 2][down], grid->generation_deps[s % 2][left], \
+                   grid->generation_deps[s % 2][right]) \
+        depend(out: grid->generation_deps[(s + 1) % 2][t])
+            update_tile(mat, buf, &grid->tile_alive[s * n_tiles + t], &grid->tile_delta[s * n_tiles + t], height,
+                        width, halo, grid, t, regions[s]);
+        }
+    }
+
+    // Reduce stats of tiles.
+    for (unsigned int s = 0; s < steps; s++) {
+        grid->step_alive[s] = 0;
+        grid->step_delta[s] = 0;
+
+        for (unsigned int t = 0; t < n_tiles; t++) {
+            grid->step_alive[s] += grid->tile_alive[s * n_tiles + t];
+            grid->step_delta[s] += grid->tile_delta[s * n_tiles + t];
+        }
+    }
+
+    if (grid->track_activity) {
+        update_tile_activity(grid);
+    }
+}
+
+
+#endif //MPP_AUTOMATON_TILED_POPULATION_H